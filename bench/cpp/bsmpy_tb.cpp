@@ -0,0 +1,426 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	bsmpy_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	A bulk test-bench for the multiplies generated by bldmpy, based
+//		upon the bit-sliced model of each core that "bldmpy -s"
+//	writes into bsmpy_NxM.h.  In a bit-sliced model, every signal is an
+//	array of words with one word per bit, and every bit of a word belongs
+//	to a different pair of operands.  One evaluation of the model
+//	therefore multiplies 64, 256, or 512 pairs of operands at once (-l).
+//
+//	The test takes place in two parts.  First, a random sample of
+//	operands (-n) is given to both the Verilated umpy_NxM and sgnmpy_NxM
+//	cores and to the bit-sliced model, to make certain the model matches
+//	the cores.  Then every possible pair of operands is given to the
+//	model alone, and checked against an independent (bit-sliced)
+//	schoolbook multiply.  -j splits this sweep across several threads.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015,2018-2019, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "verilated.h"
+#include "components.h"
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+typedef	MPYCAT(Vsgnmpy_, MPYSZ, )	Vsgn;
+typedef	MPYCAT(Vumpy_, MPYSZ, )	Vumpy;
+
+#define	UDESC(X)	MPYCAT(UMPY_, MPYSZ, X)
+#define	SDESC(X)	MPYCAT(SGNMPY_, MPYSZ, X)
+#define	BSUMPY		MPYCAT(bsumpy_, MPYSZ, )
+#define	BSSGNMPY	MPYCAT(bssgnmpy_, MPYSZ, )
+
+static const int	NA = UDESC(_NA), NB = UDESC(_NB), NP = NA+NB;
+static const int	ULAT = MPYCLOCKS(UDESC(_DELAY)),
+			SLAT = MPYCLOCKS(SDESC(_DELAY));
+static const bool	UAUX = UDESC(_AUX), SAUX = SDESC(_AUX),
+			UASYNC = UDESC(_ASYNC_RESET),
+			SASYNC = SDESC(_ASYNC_RESET);
+
+static_assert((SDESC(_NA) == NA)&&(SDESC(_NB) == NB),
+	"The signed core doesn't match the unsigned one");
+static_assert(NP < 64, "The products must fit in a long");
+
+// The three word sizes, for 64, 256, and 512 lanes
+typedef	uint64_t	BS64;
+typedef	uint64_t	BS256 __attribute__((vector_size(32)));
+typedef	uint64_t	BS512 __attribute__((vector_size(64)));
+
+//
+// Lane access.  These are only used to pack or unpack the few operands
+// given to the Verilated cores, or to report a failure, so they needn't be
+// fast.
+template<class W> static inline int	getbit(const W &w, const int lane) {
+	const uint64_t	*p = (const uint64_t *)&w;
+
+	return (p[lane>>6] >> (lane&63))&1;
+}
+
+template<class W> static inline void	setbit(W &w, const int lane, int v) {
+	uint64_t	*p = (uint64_t *)&w;
+
+	if (v)
+		p[lane>>6] |= (1ul << (lane&63));
+	else
+		p[lane>>6] &= ~(1ul << (lane&63));
+}
+
+template<class W> static inline bool	anyset(const W &w) {
+	const uint64_t	*p = (const uint64_t *)&w;
+	uint64_t	r = 0;
+
+	for(unsigned k=0; k<sizeof(W)/8; k++)
+		r |= p[k];
+	return r != 0;
+}
+
+template<class W> static void	pack(W *w, const int nbits, const int lane,
+		const unsigned long v) {
+	for(int k=0; k<nbits; k++)
+		setbit(w[k], lane, (v>>k)&1);
+}
+
+template<class W> static unsigned long	unpack(const W *w, const int nbits,
+		const int lane) {
+	unsigned long	v = 0;
+
+	for(int k=0; k<nbits; k++)
+		v |= (unsigned long)getbit(w[k], lane) << k;
+	return v;
+}
+
+//
+// refmpy
+//
+// The reference for the sweep: a schoolbook multiply, written
+// independently of the model, with A sign extended and the top row
+// subtracted rather than added when the multiply is signed.
+template<class W> static void	refmpy(W *r, const W *a, const W *b,
+		const bool sgn) {
+	W		x[NP];
+
+	for(int k=0; k<NP; k++) {
+		x[k] = (k < NA) ? a[k] : ((sgn) ? a[NA-1] : W{});
+		r[k] = W{};
+	}
+
+	for(int j=0; j<NB; j++) {
+		// -(row << j) == ((~row)+1) << j, within NP bits
+		W	sub = ((sgn)&&(j == NB-1)) ? ~W{} : W{};
+		W	c = sub;
+
+		for(int k=j; k<NP; k++) {
+			W	row = (x[k-j] & b[j]) ^ sub;
+			W	h = r[k] ^ row;
+			W	sum = h ^ c;
+
+			c = (r[k] & row) | (h & c);
+			r[k] = sum;
+		}
+	}
+}
+
+//
+// idxbit
+//
+// Sets w to bit k of the operand index, {b,a}, across every lane of a step
+// starting at base.  Bits below lg(lanes) vary from lane to lane, the rest
+// are the same across all lanes.
+template<class W> static inline void	idxbit(W &w, const long base,
+		const int k) {
+	static const uint64_t	pat[6] = {
+		0xaaaaaaaaaaaaaaaaul, 0xccccccccccccccccul,
+		0xf0f0f0f0f0f0f0f0ul, 0xff00ff00ff00ff00ul,
+		0xffff0000ffff0000ul, 0xffffffff00000000ul };
+	uint64_t	*p = (uint64_t *)&w;
+
+	for(unsigned e=0; e<sizeof(W)/8; e++) {
+		if (k < 6)
+			p[e] = pat[k];
+		else
+			p[e] = (((base + 64*e) >> k)&1) ? ~0ul : 0ul;
+	}
+}
+
+//
+// BSTB
+//
+// Drives the two Verilated cores, one product per clock, for the sampled
+// half of the test.
+class	BSTB {
+public:
+	Vsgn	*m_score;
+	Vumpy	*m_ucore;
+
+	BSTB(void) {
+		m_score = new Vsgn;
+		m_ucore = new Vumpy;
+	}
+	~BSTB(void) {
+		delete m_ucore;
+		delete m_score;
+	}
+
+	void	tick(void) {
+		::tick(m_score);
+		::tick(m_ucore);
+	}
+
+	void	reset(void) {
+		m_score->i_ce = 1;
+		m_ucore->i_ce = 1;
+		m_score->i_a = 0;
+		m_ucore->i_a = 0;
+		m_score->i_b = 0;
+		m_ucore->i_b = 0;
+		setaux<SAUX>(m_score, 0);
+		setaux<UAUX>(m_ucore, 0);
+
+		setreset<SASYNC>(m_score, true);
+		setreset<UASYNC>(m_ucore, true);
+		tick();
+		setreset<SASYNC>(m_score, false);
+		setreset<UASYNC>(m_ucore, false);
+	}
+};
+
+//
+// sample
+//
+// Check the model against the Verilated cores on nsamples random operands
+template<class W> bool	sample(const long nsamples) {
+	const int	LANES = 8*sizeof(W);
+	long		nsteps = (nsamples + LANES-1) / LANES, n;
+	std::vector<unsigned long>	ia, ib, up, sp;
+	BSTB	*tb = new BSTB;
+	bool	pass = true;
+
+	n = nsteps * LANES;
+	ia.resize(n + SLAT + ULAT, 0);
+	ib.resize(ia.size(), 0);
+	up.resize(ia.size(), 0);
+	sp.resize(ia.size(), 0);
+
+	for(long s=0; s<nsteps; s++) {
+		W	a[NA], b[NB], u[NP], p[NP];
+
+		for(int l=0; l<LANES; l++) {
+			long	k = s * LANES + l;
+
+			ia[k] = urand<NA>();
+			ib[k] = urand<NB>();
+			pack(a, NA, l, ia[k]);
+			pack(b, NB, l, ib[k]);
+		}
+
+		BSUMPY(u, a, b);
+		BSSGNMPY(p, a, b);
+		for(int l=0; l<LANES; l++) {
+			up[s * LANES + l] = unpack(u, NP, l);
+			sp[s * LANES + l] = unpack(p, NP, l);
+		}
+	}
+
+	// The trailing zeros flush the last products out of each core,
+	// and multiply to zero in any model
+	tb->reset();
+	for(long k=0; k<(long)ia.size(); k++) {
+		unsigned long	uout, sout;
+		long		ku, ks;
+
+		tb->m_ucore->i_a = ia[k];
+		tb->m_ucore->i_b = ib[k];
+		tb->m_score->i_a = ia[k];
+		tb->m_score->i_b = ib[k];
+		tb->tick();
+
+		uout = ubits<NP>(tb->m_ucore->o_p);
+		sout = ubits<NP>(tb->m_score->o_p);
+
+		// After this clock, o_p holds the product from LAT-1 clocks ago
+		ku = k + 1 - ULAT;
+		ks = k + 1 - SLAT;
+		if ((ku >= 0)&&(ku < n)&&(uout != up[ku])) {
+			printf("MODEL MISMATCH (U): %lx * %lx, core %lx != model %lx\n",
+				ia[ku], ib[ku], uout, up[ku]);
+			pass = false;
+			break;
+		} if ((ks >= 0)&&(ks < n)&&(sout != sp[ks])) {
+			printf("MODEL MISMATCH (S): %lx * %lx, core %lx != model %lx\n",
+				ia[ks], ib[ks], sout, sp[ks]);
+			pass = false;
+			break;
+		}
+	}
+
+	delete	tb;
+	if (pass)
+		printf("The model matches the cores on %ld random products\n", n);
+	return pass;
+}
+
+//
+// sweep
+//
+// Multiply every possible pair of operands in the model, checking the
+// results against refmpy().  Each of nthreads threads takes every
+// nthreads'th step.
+template<class W> bool	sweep(const int nthreads) {
+	const int	LANES = 8*sizeof(W);
+	const long	total = 1l << NP;
+	const long	nsteps = (total > LANES) ? total / LANES : 1;
+	std::atomic<bool>	failed(false);
+	std::vector<std::thread>	workers;
+
+	auto	worker = [&](const int id) {
+		for(long s=id; s<nsteps; s+=nthreads) {
+			W	a[NA], b[NB], u[NP], p[NP], r[NP],
+				diff = W{};
+			long	base = s * LANES;
+
+			if (failed)
+				return;
+
+			for(int k=0; k<NA; k++)
+				idxbit(a[k], base, k);
+			for(int k=0; k<NB; k++)
+				idxbit(b[k], base, NA+k);
+
+			BSUMPY(u, a, b);
+			refmpy(r, a, b, false);
+			for(int k=0; k<NP; k++)
+				diff |= u[k] ^ r[k];
+
+			BSSGNMPY(p, a, b);
+			refmpy(r, a, b, true);
+			for(int k=0; k<NP; k++)
+				diff |= p[k] ^ r[k];
+
+			if (anyset(diff)) {
+				int	l = 0;
+
+				while(!getbit(diff, l))
+					l++;
+				if (!failed.exchange(true)) {
+					unsigned long	va = unpack(a, NA, l),
+							vb = unpack(b, NB, l);
+
+					printf("WRONG ANSWER: %lx * %lx = %lx (U), %lx (S), not %lx (U), %lx (S)\n",
+						va, vb,
+						unpack(u, NP, l),
+						unpack(p, NP, l),
+						ubits<NP>(va * vb),
+						ubits<NP>(sbits<NA>(va)
+							* sbits<NB>(vb)));
+				}
+				return;
+			}
+		}
+	};
+
+	for(int k=1; k<nthreads; k++)
+		workers.push_back(std::thread(worker, k));
+	worker(0);
+	for(auto &t : workers)
+		t.join();
+
+	if (!failed)
+		printf("All %ld products match\n", total);
+	return !failed;
+}
+
+template<class W> bool	runtest(const long nsamples, const int nthreads) {
+	time_t	start = time(NULL);
+	bool	pass;
+
+	pass = sample<W>(nsamples);
+	if (pass)
+		pass = sweep<W>(nthreads);
+	if (pass)
+		printf("%d lanes, %ld seconds\n", (int)(8*sizeof(W)),
+			(long)(time(NULL) - start));
+	return pass;
+}
+
+void	usage(void) {
+	printf("USAGE: bsmpy_tb [-j <threads>] [-l 64|256|512] [-n <samples>]\n");
+}
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	int	nthreads = 1, lanes = 64, c;
+	long	nsamples = 65536;
+	bool	pass;
+
+	while((c = getopt(argc, argv, "j:l:n:")) != -1) {
+		switch(c) {
+		case 'j':	nthreads = atoi(optarg); break;
+		case 'l':	lanes = atoi(optarg); break;
+		case 'n':	nsamples = atol(optarg); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (nthreads <= 0)
+		nthreads = std::thread::hardware_concurrency();
+	if (nthreads <= 0)
+		nthreads = 1;
+
+	switch(lanes) {
+	case  64: pass = runtest<BS64>(nsamples, nthreads);	break;
+	case 256: pass = runtest<BS256>(nsamples, nthreads);	break;
+	case 512: pass = runtest<BS512>(nsamples, nthreads);	break;
+	default:
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if (pass) {
+		printf("SUCCESS!\n");
+		exit(EXIT_SUCCESS);
+	} else {
+		printf("TEST FAILED\n");
+		exit(EXIT_FAILURE);
+	}
+}
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	cmplx_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	A test bench for the complex multiply cores written by
+//		"bldmpy --complex".  When there are few enough of them, every
+//	combination of i_ar, i_ai, i_br, and i_bi is tried.  Otherwise the
+//	extremes of each operand are tried against each other, followed by a
+//	million random operands.  i_ce is dropped about a quarter of the time
+//	to check that o_pr, o_pi and o_aux hold, and both parts of every
+//	product are checked against the product found the simple way.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(CMPLX.h)
+#include PMSTR(CMPLXH.h)
+
+#define	CDESC(X)	MPYCAT(CMPLX_, MPYSZ, X)
+
+static const int	NA = CDESC(_NA), NB = CDESC(_NB), NP = CDESC(_NP);
+
+static_assert(NP < 64, "The products must fit in a long");
+
+MPYTBCORE(CCORE, CMPLX, CDESC, true, "CMPLX")
+
+// Operands, all four together, beyond which the sweep is no longer exhaustive
+static const int	MAXEXHAUSTIVE = 24;
+static const long	NRANDOM = 1000000;
+static const bool	exhaustive = (2*(NA+NB) <= MAXEXHAUSTIVE);
+static const long	nextreme = 5*5*5*5,
+			total = (exhaustive) ? (1l << (2*(NA+NB)))
+				: (nextreme + NRANDOM);
+static const unsigned long	aext[5] = { 0, 1, ubits<NA>(-1),
+					1ul << (NA-1), (1ul << (NA-1))-1 },
+			bext[5] = { 0, 1, ubits<NB>(-1),
+					1ul << (NB-1), (1ul << (NB-1))-1 };
+
+// The operands given on one clock
+struct	CMPLXIN {
+	unsigned long	ar, ai, br, bi;
+	int		aux;
+};
+
+//
+// CMPLXSTIM
+//
+// Every set of operands in turn, if there aren't too many.  Otherwise, every
+// combination of the extremes of each part, followed by random operands.
+//
+struct	CMPLXSTIM {
+	typedef	CMPLXIN	IN;
+
+	void	given(const long n, CMPLXIN &in) {
+		if (n >= total) {
+			in.ar = in.ai = in.br = in.bi = 0;
+		} else if (exhaustive) {
+			in.ar = ubits<NA>(n >> (NA+2*NB));
+			in.ai = ubits<NA>(n >> (2*NB));
+			in.br = ubits<NB>(n >> NB);
+			in.bi = ubits<NB>(n);
+		} else if (n < nextreme) {
+			in.ar = aext[n / 125];
+			in.ai = aext[(n / 25) % 5];
+			in.br = bext[(n / 5) % 5];
+			in.bi = bext[n % 5];
+		} else
+			idle(in);
+	}
+
+	void	idle(CMPLXIN &in) {
+		in.ar = urand<NA>();
+		in.ai = urand<NA>();
+		in.br = urand<NB>();
+		in.bi = urand<NB>();
+	}
+
+	template<class V> void	apply(V *core, const CMPLXIN &in) {
+		core->i_ar = in.ar;
+		core->i_ai = in.ai;
+		core->i_br = in.br;
+		core->i_bi = in.bi;
+	}
+};
+
+struct	CMPLXCHECK {
+	template<class C> bool	check(typename C::V *core, const CMPLXIN *in) {
+		long		ar, ai, br, bi;
+		unsigned long	pr, pi;
+
+		if (!in)
+			return true;
+
+		ar = sbits<NA>(in->ar);
+		ai = sbits<NA>(in->ai);
+		br = sbits<NB>(in->br);
+		bi = sbits<NB>(in->bi);
+		pr = ubits<NP>(ar * br - ai * bi);
+		pi = ubits<NP>(ar * bi + ai * br);
+
+		if (((unsigned long)core->o_pr != pr)
+				||((unsigned long)core->o_pi != pi)) {
+			printf("WRONG PRODUCT: (%ld + %ldj) * (%ld + %ldj) = (%lx, %lx), not (%lx, %lx)\n",
+				ar, ai, br, bi, (unsigned long)core->o_pr,
+				(unsigned long)core->o_pi, pr, pi);
+			return false;
+		}
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	CMPLXSTIM	stim;
+	CMPLXCHECK	chk;
+
+	runbench<CCORE>(stim, chk, total);
+
+	printf("All %ld%s complex products of %dx%d bits, from %d multiplies, pass\n",
+		total, (exhaustive) ? "" : " extreme and random", NA, NB,
+		CDESC(_MPYS));
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
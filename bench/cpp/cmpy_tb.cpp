@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	cmpy_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	Checks the cycle-accurate C++ models bldmpy writes
+//		(cumpy_NxM.h and csgnmpy_NxM.h) against the Verilated
+//	cores they are meant to replace.  Both are given the same random
+//	operands, aux bits, clock enables, and resets, and their outputs are
+//	compared on every clock.  Every size in mpysizes.h is checked in turn.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015,2018-2019, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "verilated.h"
+#include "mpycores.h"
+
+//
+// step()
+//
+// Apply one clock's worth of inputs to both the Verilated core, V, and its
+// C++ model, M, then compare their outputs.  Both cores were built with the
+// same aux and reset options.
+template<int NP, bool AUX, bool ASYNC, class V, class M> bool	step(V *v,
+		M *m, const int rst, const int ce, const unsigned long a,
+		const unsigned long b, const int aux) {
+	v->i_ce = m->i_ce = ce;
+	v->i_a = m->i_a = a;
+	v->i_b = m->i_b = b;
+	setaux<AUX>(v, aux);
+	setaux<AUX>(m, aux);
+	setreset<ASYNC>(v, rst);
+	setreset<ASYNC>(m, rst);
+
+	tick(v);
+	tick(m);
+
+	if (ubits<NP>(v->o_p) != ubits<NP>(m->o_p))
+		return false;
+	if (getaux<AUX>(v) != getaux<AUX>(m))
+		return false;
+	return true;
+}
+
+//
+// cmpysize()
+//
+// Run both models of one size side by side for nclocks
+template<class C> void	cmpysize(const char *sz, const long nclocks) {
+	if constexpr (!C::HAS_CMODEL) {
+		printf("No C++ models of the %s multiplies\n", sz);
+	} else {
+		const int	NA = C::NA, NB = C::NB, NP = NA+NB;
+		typename C::VUMPY	*vu = new typename C::VUMPY;
+		typename C::VSGN	*vs = new typename C::VSGN;
+		typename C::CUMPY	*cu = new typename C::CUMPY;
+		typename C::CSGN	*cs = new typename C::CSGN;
+
+		for(long k=0; k<nclocks; k++) {
+			// Hold the reset for the first clock, then pulse it
+			// about one clock in a thousand.  Drop i_ce about a
+			// quarter of the time
+			int	rst = (k == 0)||((rand() & 0x3ff) == 0),
+				ce  = !dropce(),
+				aux = rand() & 1;
+			unsigned long	a = urand<NA>(), b = urand<NB>();
+
+			if (!step<NP, C::UAUX, C::UASYNC>(vu, cu, rst, ce,
+					a, b, aux)) {
+				printf("UMPY %s MISMATCH, clock %ld: Verilator %lx, C++ %lx\n",
+					sz, k, ubits<NP>(vu->o_p),
+					ubits<NP>(cu->o_p));
+				printf("TEST FAILED\n");
+				exit(EXIT_FAILURE);
+			}
+
+			if (!step<NP, C::SAUX, C::SASYNC>(vs, cs, rst, ce,
+					a, b, aux)) {
+				printf("SGNMPY %s MISMATCH, clock %ld: Verilator %lx, C++ %lx\n",
+					sz, k, ubits<NP>(vs->o_p),
+					ubits<NP>(cs->o_p));
+				printf("TEST FAILED\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		vu->final();
+		vs->final();
+		delete vu;
+		delete vs;
+		delete cu;
+		delete cs;
+
+		printf("%s: %ld clocks match\n", sz, nclocks);
+	}
+}
+
+void	usage(void) {
+	printf("USAGE: cmpy_tb [-n <clocks>]\n");
+}
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	long	nclocks = 1l << 20;
+	int	c;
+
+	while((c = getopt(argc, argv, "n:")) != -1) {
+		switch(c) {
+		case 'n':	nclocks = atol(optarg); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+#define	MPYSIZE(SZ, A, B)	cmpysize<MPYCAT(MPYCORE_, SZ, )>(#SZ, nclocks);
+#include "mpysizes.h"
+#undef	MPYSIZE
+
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	constmpy_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	An exhaustive test bench for the constant multiply cores that
+//		"bldmpy --const" builds.  Every i_a is multiplied by every
+//	one of the core's constants, with i_ce dropped about a quarter of the
+//	time to check that o_p holds, and each product checked the number of
+//	clocks (with i_ce) after i_a that the core's description gives.  Which
+//	core is tested depends upon the CMPY (Verilated model), CMPYH (its
+//	description), and CMPYD (the description's prefix) macros, which the
+//	mkconst_<name>.mk that bldmpy writes gives.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(CMPY.h)
+#include PMSTR(CMPYH.h)
+
+#define	CMCAT_(A,B)	A ## B
+#define	CMCAT(A,B)	CMCAT_(A,B)
+#define	CDESC(X)	CMCAT(CMPYD, X)
+
+static const int	NA = CDESC(_NA), NP = CDESC(_NP),
+			NCOEFS = CDESC(_NCOEFS);
+static const long	coefs[NCOEFS] = CDESC(_COEFS);
+static const long	total = 1l << NA;
+
+static_assert(NP < 64, "The products must fit in a long");
+
+MPYTBCORE(CCORE, CMPY, CDESC, true, "CONST")
+
+// The i_a given on one clock
+struct	CONSTIN {
+	long	a;
+	int	aux;
+};
+
+// Every i_a in turn
+struct	CONSTSTIM {
+	typedef	CONSTIN	IN;
+
+	void	given(const long n, CONSTIN &in) {
+		in.a = sbits<NA>(n);
+	}
+
+	void	idle(CONSTIN &in) {
+		in.a = sbits<NA>(rand());
+	}
+
+	template<class V> void	apply(V *core, const CONSTIN &in) {
+		core->i_a = ubits<NA>(in.a);
+	}
+};
+
+// Check every product against the i_a given to the core.  Until then, the
+// reset should've left o_p as it would be for an i_a of zero.
+struct	CONSTCHECK {
+	template<class C> bool	check(typename C::V *core, const CONSTIN *in) {
+		const long	a = (in) ? in->a : 0;
+
+		for(int k=0; k<NCOEFS; k++) {
+			long	exp = sbits<NP>(a * coefs[k]),
+				out = sbits<NP>(getbits(core->o_p, k*NP, NP));
+
+			if (out != exp) {
+				printf("%ld * %ld = %ld, not %ld\n", a,
+					coefs[k], out, exp);
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	CONSTSTIM	stim;
+	CONSTCHECK	chk;
+
+	runbench<CCORE>(stim, chk, total);
+
+	printf("All %ld inputs match, %d constant%s\n", total, NCOEFS,
+		(NCOEFS > 1) ? "s":"");
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
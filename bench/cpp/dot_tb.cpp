@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	dot_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	A test bench for the dot product cores written by
+//		"bldmpy --dot <count>".  When there are few enough of them,
+//	every i_a and i_b is given to both udotN_AxB and sgndotN_AxB.
+//	Otherwise every product is given the same extremes of each operand,
+//	followed by a million random operands.  i_ce is dropped about a quarter
+//	of the time to check that o_p and o_aux hold, and every o_p is checked
+//	against the sum of the products found the simple way.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(UDP.h)
+#include PMSTR(SDP.h)
+#include PMSTR(UDPH.h)
+#include PMSTR(SDPH.h)
+
+#define	UDESC(X)	MPYCAT(UDOT, DOTSZ, X)
+#define	SDESC(X)	MPYCAT(SGNDOT, DOTSZ, X)
+
+static const int	N = UDESC(_N), NA = UDESC(_NA), NB = UDESC(_NB),
+			NP = UDESC(_NP);
+
+static_assert(NP < 64, "The sums must fit in a long");
+static_assert((SDESC(_N) == N)&&(SDESC(_NA) == NA)&&(SDESC(_NB) == NB),
+	"The signed and unsigned cores don't match");
+
+MPYTBCORE(UCORE, UDP, UDESC, false, "U")
+MPYTBCORE(SCORE, SDP, SDESC, true, "SGN")
+
+// Bits of all of the operands together beyond which the sweep is no longer
+// exhaustive
+static const int	MAXEXHAUSTIVE = 24;
+static const long	NRANDOM = 1000000;
+static const bool	exhaustive = (N*(NA+NB) <= MAXEXHAUSTIVE);
+static const unsigned long	aext[5] = { 0, 1, ubits<NA>(-1),
+					1ul << (NA-1), (1ul << (NA-1))-1 },
+			bext[5] = { 0, 1, ubits<NB>(-1),
+					1ul << (NB-1), (1ul << (NB-1))-1 };
+static const long	nextreme = 5*5,
+			total = (exhaustive) ? (1l << (N*(NA+NB)))
+				: (nextreme + NRANDOM);
+
+// The operands given on one clock
+struct	DOTIN {
+	unsigned long	a[N], b[N];
+	int		aux;
+};
+
+template<class V> void	setops(V *core, const unsigned long *a,
+		const unsigned long *b) {
+	clrbits(core->i_a);
+	clrbits(core->i_b);
+	for(int k=0; k<N; k++) {
+		orbits(core->i_a, k*NA, NA, a[k]);
+		orbits(core->i_b, k*NB, NB, b[k]);
+	}
+}
+
+//
+// DOTSTIM
+//
+// Every set of operands in turn, if there aren't too many.  Otherwise, the
+// extreme operands, the same in every column, followed by random ones.
+//
+struct	DOTSTIM {
+	typedef	DOTIN	IN;
+
+	void	given(const long n, DOTIN &in) {
+		for(int k=0; k<N; k++) {
+			if (n >= total) {
+				in.a[k] = in.b[k] = 0;
+			} else if (exhaustive) {
+				in.a[k] = ubits<NA>(n >> (k*(NA+NB)+NB));
+				in.b[k] = ubits<NB>(n >> (k*(NA+NB)));
+			} else if (n < nextreme) {
+				in.a[k] = aext[n / 5];
+				in.b[k] = bext[n % 5];
+			} else {
+				in.a[k] = urand<NA>();
+				in.b[k] = urand<NB>();
+			}
+		}
+	}
+
+	void	idle(DOTIN &in) {
+		for(int k=0; k<N; k++) {
+			in.a[k] = urand<NA>();
+			in.b[k] = urand<NB>();
+		}
+	}
+
+	template<class V> void	apply(V *core, const DOTIN &in) {
+		setops(core, in.a, in.b);
+	}
+};
+
+struct	DOTCHECK {
+	template<class C> bool	check(typename C::V *core, const DOTIN *in) {
+		long	p = 0;
+
+		if (!in)
+			return true;
+
+		for(int k=0; k<N; k++) {
+			if (C::SGN)
+				p += sbits<NA>(in->a[k]) * sbits<NB>(in->b[k]);
+			else
+				p += in->a[k] * in->b[k];
+		}
+
+		if ((unsigned long)core->o_p != ubits<NP>(p)) {
+			printf("WRONG %s-SUM: %lx, not %lx, of\n", C::NAME,
+				(unsigned long)core->o_p, ubits<NP>(p));
+			for(int k=0; k<N; k++)
+				printf("\t%lx * %lx\n", in->a[k], in->b[k]);
+			return false;
+		}
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	DOTSTIM		stim;
+	DOTCHECK	chk;
+
+	runbench<UCORE>(stim, chk, total);
+	runbench<SCORE>(stim, chk, total);
+
+	printf("All %ld%s sums of %d %dx%d products, from %d rows, pass\n",
+		total, (exhaustive) ? "" : " extreme and random", N, NA, NB,
+		UDESC(_ROWS));
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	kmpy_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	An exhaustive test-bench for the lane wrappers written by
+//		"bldmpy -k <lanes>".  kumpy_NxM and ksgnmpy_NxM each hold
+//	LANES copies of their core, side by side, so every clock (and every
+//	eval()) given to the Verilated wrapper multiplies LANES pairs of
+//	operands rather than one.  Every lane is given a new pair of operands
+//	on every clock, and every lane's product (and aux bit) is checked
+//	against the latency given in the core's description.
+//
+//	-j splits the sweep across several threads, each with its own copy
+//	of both wrappers and its own contiguous range of operands.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015,2018-2019, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "verilated.h"
+#include "components.h"
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+typedef	KSMPY	Vksgn;
+typedef	KUMPY	Vkumpy;
+
+#define	UDESC(X)	MPYCAT(UMPY_, MPYSZ, X)
+#define	SDESC(X)	MPYCAT(SGNMPY_, MPYSZ, X)
+
+static_assert((UDESC(_NA) == NA)&&(UDESC(_NB) == NB),
+	"The unsigned core doesn't match this test bench");
+static_assert(NA+NB < 64, "The products must fit in a long");
+
+static const int	NP = NA+NB;
+static const int	ULAT = MPYCLOCKS(UDESC(_DELAY)),
+			SLAT = MPYCLOCKS(SDESC(_DELAY));
+static const bool	ASYNC = UDESC(_ASYNC_RESET);
+
+// Scramble the aux bit, so that any misalignment between it and o_p will
+// show up
+static inline int	auxbit(const long idx) {
+	return (((unsigned long)idx * 0x9e3779b97f4a7c15ul) >> 63)&1;
+}
+
+//
+// KLANECHECK
+//
+// The operands given to one wrapper on each of its last DLY clocks, by
+// the index of the first lane.  -1 marks a clock with nothing to check.
+template<int DLY> struct	KLANECHECK {
+	long	m_base[DLY];
+
+	KLANECHECK(void) {
+		for(int k=0; k<DLY; k++)
+			m_base[k] = -1;
+	}
+};
+
+//
+// sweep()
+//
+// Test every operand index in [lo, hi), where the index is given by
+// (a << NB) | b, LANES indices per clock.  Returns false, having said why,
+// on the first failure.
+bool	sweep(const long lo, const long hi, std::atomic<bool> &failed) {
+	const long	bmsk = (1l << NB)-1;
+	const long	nclocks = (hi - lo + LANES - 1) / LANES;
+	const int	maxlat = (ULAT > SLAT) ? ULAT : SLAT;
+	Vkumpy		*ku = new Vkumpy;
+	Vksgn		*ks = new Vksgn;
+	KLANECHECK<ULAT>	uchk;
+	KLANECHECK<SLAT>	schk;
+	bool		pass = true;
+
+	ku->i_ce = ks->i_ce = 1;
+	clrbits(ku->i_a); clrbits(ku->i_b);
+	clrbits(ks->i_a); clrbits(ks->i_b);
+#if	UDESC(_AUX)
+	clrbits(ku->i_aux); clrbits(ks->i_aux);
+#endif
+	setreset<ASYNC>(ku, true);
+	setreset<ASYNC>(ks, true);
+	tick(ku);
+	tick(ks);
+	setreset<ASYNC>(ku, false);
+	setreset<ASYNC>(ks, false);
+
+	for(long n=0; (pass)&&(n < nclocks + maxlat - 1); n++) {
+		long	base = (n < nclocks) ? lo + n * LANES : -1;
+
+		if (((n & 0x3ff) == 0)&&(failed))
+			break;
+
+		if (base >= 0) {
+			clrbits(ku->i_a); clrbits(ku->i_b);
+#if	UDESC(_AUX)
+			clrbits(ku->i_aux);
+#endif
+			for(int l=0; l<LANES; l++) {
+				long	idx = base + l;
+				unsigned long	a = ubits<NA>(idx >> NB),
+						b = idx & bmsk;
+
+				orbits(ku->i_a, l*NA, NA, a);
+				orbits(ku->i_b, l*NB, NB, b);
+#if	UDESC(_AUX)
+				orbits(ku->i_aux, l, 1, auxbit(idx));
+#endif
+			}
+			// Both wrappers get the same operands
+			memcpy(&ks->i_a, &ku->i_a, sizeof(ks->i_a));
+			memcpy(&ks->i_b, &ku->i_b, sizeof(ks->i_b));
+#if	UDESC(_AUX)
+			memcpy(&ks->i_aux, &ku->i_aux, sizeof(ks->i_aux));
+#endif
+		}
+		uchk.m_base[n % ULAT] = base;
+		schk.m_base[n % SLAT] = base;
+
+		tick(ku);
+		tick(ks);
+
+		// After this clock, o_p holds the products given DLY-1
+		// clocks ago.  Until then, it holds only what the reset left
+		// in it, which the -1's left in KLANECHECK skip.
+		long	ubase = uchk.m_base[(n+1) % ULAT],
+			sbase = schk.m_base[(n+1) % SLAT];
+
+		for(int l=0; (ubase >= 0)&&(l<LANES); l++) {
+			long	idx = ubase + l;
+			unsigned long	a = ubits<NA>(idx >> NB), b = idx & bmsk,
+					exp = ubits<NP>(a * b),
+					out = getbits(ku->o_p, l*NP, NP);
+#if	UDESC(_AUX)
+			int	oaux = getbits(ku->o_aux, l, 1);
+#else
+			int	oaux = auxbit(idx);
+#endif
+
+			if ((out != exp)||(oaux != auxbit(idx))) {
+				if (!failed.exchange(true))
+					printf("WRONG U-ANSWER, lane %d: %lx * %lx = %lx, not %lx (AUX %d, not %d)\n",
+						l, a, b, out, exp,
+						oaux, auxbit(idx));
+				pass = false;
+				break;
+			}
+		}
+
+		for(int l=0; (pass)&&(sbase >= 0)&&(l<LANES); l++) {
+			long	idx = sbase + l;
+			unsigned long	a = ubits<NA>(idx >> NB), b = idx & bmsk;
+			long	exp = sbits<NA>(a) * sbits<NB>(b),
+				out = sbits<NP>(getbits(ks->o_p, l*NP, NP));
+#if	UDESC(_AUX)
+			int	oaux = getbits(ks->o_aux, l, 1);
+#else
+			int	oaux = auxbit(idx);
+#endif
+
+			if ((out != exp)||(oaux != auxbit(idx))) {
+				if (!failed.exchange(true))
+					printf("WRONG SGN-ANSWER, lane %d: %lx * %lx = %lx, not %lx (AUX %d, not %d)\n",
+						l, a, b, out, exp,
+						oaux, auxbit(idx));
+				pass = false;
+				break;
+			}
+		}
+	}
+
+	ku->final();
+	ks->final();
+	delete ku;
+	delete ks;
+	return pass;
+}
+
+void	usage(void) {
+	printf("USAGE: kmpy_tb [-j <threads>]\n");
+}
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	const long	total = 1l << (NA+NB);
+	int		nthreads = 1, c;
+	std::atomic<bool>		failed(false);
+	std::vector<std::thread>	workers;
+	time_t		start = time(NULL);
+
+	while((c = getopt(argc, argv, "j:")) != -1) {
+		switch(c) {
+		case 'j':	nthreads = atoi(optarg); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (nthreads <= 0)
+		nthreads = std::thread::hardware_concurrency();
+	if (nthreads <= 0)
+		nthreads = 1;
+
+	for(int k=0; k<nthreads; k++)
+		workers.push_back(std::thread(sweep,
+			(total * k) / nthreads, (total * (k+1)) / nthreads,
+			std::ref(failed)));
+	for(auto &t : workers)
+		t.join();
+
+	if (failed) {
+		printf("TEST FAILED\n");
+		exit(EXIT_FAILURE);
+	}
+
+	printf("All %ld products match, %d lanes, %ld seconds\n", total,
+		LANES, (long)(time(NULL) - start));
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
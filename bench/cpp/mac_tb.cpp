@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	mac_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	An exhaustive test bench for the multiply-accumulate cores
+//		written by "bldmpy --mac <bits>".  Every i_a is tried against
+//	every i_b, in both umac_NxM and sgnmac_NxM, with i_clr raised about one
+//	time in sixteen to start a new sum, and i_ce dropped about a quarter of
+//	the time to check that o_acc holds.  The running sum is checked after
+//	every clock, against the latency given in each core's description.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(UMAC.h)
+#include PMSTR(SMAC.h)
+#include PMSTR(UMACH.h)
+#include PMSTR(SMACH.h)
+
+#define	UDESC(X)	MPYCAT(UMAC_, MPYSZ, X)
+#define	SDESC(X)	MPYCAT(SGNMAC_, MPYSZ, X)
+
+static const int	NA = UDESC(_NA), NB = UDESC(_NB),
+			NACC = UDESC(_NACC);
+
+static_assert(NACC <= 64, "The sums must fit in a long");
+static_assert((SDESC(_NA) == NA)&&(SDESC(_NB) == NB)
+		&&(SDESC(_NACC) == NACC),
+	"The signed and unsigned cores don't match");
+
+MPYTBCORE(UCORE, UMAC, UDESC, false, "U")
+MPYTBCORE(SCORE, SMAC, SDESC, true, "SGN")
+
+// The operands given on one clock, and the sums each core should then hold
+// once they've gotten through
+struct	MACIN {
+	unsigned long	a, b;
+	int		clr, aux;
+	unsigned long	uacc, sacc;
+};
+
+//
+// MACSTIM
+//
+// Every pair of operands in turn, clearing the accumulator about one clock in
+// sixteen.  The sums are kept as the operands are given, so they don't depend
+// upon how long i_ce is held low.
+//
+struct	MACSTIM {
+	typedef	MACIN	IN;
+	unsigned long	m_uacc, m_sacc;
+
+	MACSTIM(void) {
+		m_uacc = m_sacc = 0;
+	}
+
+	void	given(const long n, MACIN &in) {
+		in.a = ubits<NA>(n >> NB);
+		in.b = ubits<NB>(n);
+		in.clr = ((rand() & 15) == 0);
+		m_uacc = ubits<NACC>(((in.clr) ? 0 : m_uacc) + in.a * in.b);
+		m_sacc = ubits<NACC>(((in.clr) ? 0 : m_sacc)
+				+ sbits<NA>(in.a) * sbits<NB>(in.b));
+		in.uacc = m_uacc;
+		in.sacc = m_sacc;
+	}
+
+	void	idle(MACIN &in) {
+		in.a = ubits<NA>(rand());
+		in.b = ubits<NB>(rand());
+		in.clr = rand() & 1;
+	}
+
+	template<class V> void	apply(V *core, const MACIN &in) {
+		core->i_a = in.a;
+		core->i_b = in.b;
+		core->i_clr = in.clr;
+	}
+};
+
+struct	MACCHECK {
+	template<class C> bool	check(typename C::V *core, const MACIN *in) {
+		unsigned long	out = core->o_acc,
+				exp = (!in) ? 0 : (C::SGN) ? in->sacc : in->uacc;
+
+		if (out != exp) {
+			printf("WRONG %s-SUM: %lx, not %lx\n", C::NAME, out, exp);
+			return false;
+		}
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	const long	total = 1l << (NA+NB);
+	MACSTIM		ustim, sstim;
+	MACCHECK	chk;
+
+	runbench<UCORE>(ustim, chk, total);
+	runbench<SCORE>(sstim, chk, total);
+
+	printf("All %ld products accumulated\n", total);
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
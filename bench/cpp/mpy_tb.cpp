@@ -10,6 +10,47 @@
 //	This file depends upon verilator to both compile, run, and therefore
 //	test sgnmpy_16x20.v
 //
+//	Every core size built in the rtl directory is linked into this one
+//	test bench, from the list in mpysizes.h.  --size 12x12,16x20 will test
+//	only those sizes, one after the other.  Otherwise every size is
+//	tested.
+//
+//	The exhaustive sweep may be split across several threads with the -j
+//	option.  Each thread then gets its own private copy of both cores,
+//	and its own contiguous shard of the (a,b) operand space.  -j 0 will
+//	use one thread per available core.
+//
+//	For sweeps too long for any one machine, --shard i/n will only test
+//	the i'th of n equal slices of the operand space, so that the sweep can
+//	be spread across many separate jobs.  --checkpoint <file> will record
+//	how far each thread has gotten once a minute.  If that file already
+//	exists when the test bench starts, the sweep picks up where it left
+//	off.  When testing more than one size, each size gets its own
+//	checkpoint, <file>.<size>.  Since the cores are reset on startup, the
+//	only pipeline state that needs to be kept is the latency of each core,
+//	which is checked against the new run.
+//
+//	Those latencies come from the umpy_NxM.h and sgnmpy_NxM.h core
+//	descriptions written by bldmpy, so the test bench knows exactly which
+//	clock each product will come out on--whether or not the core has an
+//	aux pipeline.  When it does, o_aux is checked against that same
+//	latency.
+//
+//	--fast trims each clock down to the two eval() calls Verilator needs
+//	to see a rising edge, and sweeps the signed and unsigned cores on
+//	separate threads (so -j 4 --fast runs eight) if there are CPUs
+//	enough.  --only umpy, or --only sgnmpy, evaluates and checks just the
+//	one core.  Neither changes which products are checked, or how.
+//
+//	Rather than tracing every clock, -w <n> will keep only the operands
+//	of the last n clocks.  Should a product ever fail, those n clocks are
+//	then re-run on a fresh copy of each core with tracing enabled, to
+//	produce a waveform of the failure (fail_umpy_NxM.vcd and
+//	fail_sgnmpy_NxM.vcd).  So long as n is at least the latency of each
+//	core, the pipeline will be in the same state in the re-run as it was
+//	when the product failed.  Building with "make FST=1" will write FST
+//	files rather than VCD.
+//
 // Creator:	Dan Gisselquist, Ph.D.
 //		Gisselquist Technology, LLC
 //
@@ -41,56 +82,153 @@
 //
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <string>
 
 #include "verilated.h"
+#ifdef	TRACE_FST
+#include "verilated_fst_c.h"
+typedef	VerilatedFstC	TRACEFILE;
+#define	TRACE_EXT	".fst"
+#else
 #include "verilated_vcd_c.h"
+typedef	VerilatedVcdC	TRACEFILE;
+#define	TRACE_EXT	".vcd"
+#endif
 
-#include "components.h"
-typedef	SMPY	Vsgn;
-typedef	UMPY	Vumpy;
+#include "mpycores.h"
 bool	trace = false;
 
-long	sbits(const long val, const int bits) {
-	long	r;
+// Which of the two cores are under test
+static const int	MPY_UMPY = 1, MPY_SGNMPY = 2, MPY_BOTH = 3;
 
-	r = val & ((1l<<bits)-1);
-	if (r & (1l << (bits-1)))
-		r |= (-1l << bits);
-	return r;
-}
 
-unsigned long	ubits(const long val, const int bits) {
-	unsigned long r = val & ((1l<<bits)-1);
-	return r;
-}
+//
+// MPYREPORT
+//
+// Shared by all of the sweep threads, so that progress can be reported from
+// one place, and so that the first failure will stop everyone else.
+//
+class	MPYREPORT {
+	std::mutex		m_lock;
+	std::atomic<long>	m_done;
+	std::atomic<bool>	m_failed;
+	std::atomic<int>	m_active;
+	long			m_total;
+	int			m_lastpct;
+public:
+	MPYREPORT(const long total) {
+		m_done   = 0;
+		m_failed = false;
+		m_active = 0;
+		m_total  = total;
+		m_lastpct= -1;
+	}
+
+	void	start(void)	{ m_active++; }
+	void	stop(void)	{ m_active--; }
+	bool	active(void)	{ return m_active > 0; }
+	bool	failed(void)	{ return m_failed; }
+
+	void	add(const long n) { m_done += n; }
+
+	// Returns true for the first failure only
+	bool	fail(const char *msg) {
+		std::lock_guard<std::mutex>	lock(m_lock);
+		bool	first = !m_failed;
+
+		if (first)
+			printf("%s\n", msg);
+		m_failed = true;
+		return first;
+	}
+
+	void	progress(void) {
+		std::lock_guard<std::mutex>	lock(m_lock);
+		int	pct;
 
+		pct = (m_total > 0) ? (int)((100.0 * m_done) / m_total) : 100;
+		if (pct != m_lastpct) {
+			printf("Sweep: %3d%% (%ld of %ld)\n", pct,
+				(long)m_done, m_total);
+			fflush(stdout);
+			m_lastpct = pct;
+		}
+	}
+};
 
-class	MPYTB {
+template<class C> class	MPYTB {
 public:
+	typedef	typename C::VSGN	Vsgn;
+	typedef	typename C::VUMPY	Vumpy;
+	static const int	NA = C::NA, NB = C::NB;
+	// Clocks from i_a and i_b to o_p, as given by the core descriptions
+	static const int	ULAT = C::ULAT, SLAT = C::SLAT;
+
+	static_assert(NA+NB < 8*sizeof(long), "Products must fit in a long");
+
 	Vsgn	*m_score;
 	Vumpy	*m_ucore;
-	long	svals[32];
-	unsigned long uvals[32];
-	int	m_addr, m_uoff, m_soff;
-	bool	m_usync, m_ssync;
-	VerilatedVcdC	*m_utrace, *m_strace;
+	// Expected results of every product still in flight, indexed by
+	// operand index modulo the latency of each core
+	long	svals[SLAT];
+	unsigned long uvals[ULAT];
+	bool	m_saux[SLAT], m_uaux[ULAT];
+	long	m_addr;
+	long	m_uchecked, m_schecked;
+	TRACEFILE	*m_utrace, *m_strace;
 	long	m_tickcount;
-
-	MPYTB(void) {
+	MPYREPORT	*m_report;
+	// Which cores to evaluate and check, and whether to skip the extra
+	// eval() and trace checks on every clock when nothing is traced
+	int	m_cores;
+	bool	m_fast;
+
+	// The operands of the last m_winsz products, for re-running in
+	// case of a failure
+	struct	OPERANDS { long a, b; };
+	std::vector<OPERANDS>	m_window;
+	int	m_winsz;
+	bool	m_replay;
+
+	// Every copy runs on its own thread, so each gets its own generator
+	// for the inputs it doesn't check, in place of rand()
+	unsigned	m_seed;
+	std::mt19937	m_rng;
+
+	MPYTB(const unsigned seed = 0) : m_seed(seed), m_rng(seed) {
 		m_score = new Vsgn;
 		m_ucore = new Vumpy;
 
 		Verilated::traceEverOn(true);
 
-		for(int i=0; i<32; i++)
-			svals[i] = uvals[i] = 0;
-		m_addr = 0; m_uoff = 0; m_soff = 0;
-		m_usync = false;
-		m_ssync = false;
+		for(int i=0; i<SLAT; i++) {
+			svals[i] = 0;
+			m_saux[i] = false;
+		} for(int i=0; i<ULAT; i++) {
+			uvals[i] = 0;
+			m_uaux[i] = false;
+		}
+		m_addr = 0;
+		m_uchecked = m_schecked = 0;
 
 		m_utrace = m_strace = NULL;
 		m_tickcount = 0;
+		m_report = NULL;
+		m_cores = MPY_BOTH;
+		m_fast = false;
+
+		m_winsz = 0;
+		m_replay = false;
 	}
 	~MPYTB(void) {
 		if (m_strace)
@@ -104,18 +242,18 @@ public:
 	void	opentrace(const char *pattern) {
 		char	*fname;
 
-		fname = (char *)malloc(strlen(pattern + 20));
+		fname = (char *)malloc(strlen(pattern) + 20);
 
-		if (!m_strace) {
+		if (!m_utrace) {
 			sprintf(fname, pattern, "umpy", NA, NB);
-			m_strace = new VerilatedVcdC;
-			m_score->trace(m_strace, 99);
-			m_strace->open(fname);
+			m_utrace = new TRACEFILE;
+			m_ucore->trace(m_utrace, 99);
+			m_utrace->open(fname);
 		}
 
-		if (!m_utrace) {
+		if (!m_strace) {
 			sprintf(fname, pattern, "sgnmpy", NA, NB);
-			m_strace = new VerilatedVcdC;
+			m_strace = new TRACEFILE;
 			m_score->trace(m_strace, 99);
 			m_strace->open(fname);
 		}
@@ -124,38 +262,53 @@ public:
 	}
 		
 
+	//
+	// leantick()
+	//
+	// The least that still gives Verilator a rising edge: one eval()
+	// with the clock low, to settle the new inputs and record the low
+	// clock, and one with it high.  The outputs are read with the clock
+	// still high, which is no different for logic clocked on the rising
+	// edge.
+	template<class V> static inline void	leantick(V *core) {
+		core->i_clk = 0;
+		core->eval();
+		core->i_clk = 1;
+		core->eval();
+	}
+
 	void	tick(void) {
 		m_tickcount++;
 
+		if ((m_fast)&&(!m_utrace)&&(!m_strace)) {
+			if (m_cores & MPY_SGNMPY)
+				leantick(m_score);
+			if (m_cores & MPY_UMPY)
+				leantick(m_ucore);
+			return;
+		}
+
 		m_score->i_clk = 0;
 		m_ucore->i_clk = 0;
-		m_score->eval();
-		m_ucore->eval();
+		if (m_cores & MPY_SGNMPY) m_score->eval();
+		if (m_cores & MPY_UMPY)   m_ucore->eval();
 		if (m_strace) m_strace->dump((uint64_t)(10*m_tickcount-2));
 		if (m_utrace) m_utrace->dump((uint64_t)(10*m_tickcount-2));
 
 		m_score->i_clk = 1;
 		m_ucore->i_clk = 1;
-		m_score->eval();
-		m_ucore->eval();
+		if (m_cores & MPY_SGNMPY) m_score->eval();
+		if (m_cores & MPY_UMPY)   m_ucore->eval();
 		if (m_strace) m_strace->dump((uint64_t)(10*m_tickcount));
 		if (m_utrace) m_utrace->dump((uint64_t)(10*m_tickcount));
 
 
 		m_score->i_clk = 0;
 		m_ucore->i_clk = 0;
-		m_score->eval();
-		m_ucore->eval();
+		if (m_cores & MPY_SGNMPY) m_score->eval();
+		if (m_cores & MPY_UMPY)   m_ucore->eval();
 		if (m_strace) m_strace->dump((uint64_t)(10*m_tickcount+5));
 		if (m_utrace) m_utrace->dump((uint64_t)(10*m_tickcount+5));
-
-
-		if (m_strace) {
-			m_strace->flush();
-		} if (m_utrace) {
-			m_utrace->flush();
-			printf("Flushed\n");
-		}
 	}
 
 	void	reset(void) {
@@ -163,181 +316,707 @@ public:
 		m_ucore->i_clk = 0;
 		m_score->i_ce = 1;
 		m_ucore->i_ce = 1;
-		m_score->i_a = rand();
+		m_score->i_a = ubits<NA>(m_rng());
 		m_ucore->i_a = m_score->i_a;
-		m_score->i_b = rand();
+		m_score->i_b = ubits<NB>(m_rng());
 		m_ucore->i_b = m_score->i_b;
-		m_score->i_aux = rand();
-		m_ucore->i_aux = m_score->i_aux;
+		setaux<C::SAUX>(m_score, m_rng()&1);
+		setaux<C::UAUX>(m_ucore, m_rng()&1);
 
 		for(int k=0; k<30; k++) {
 			tick();
-			m_score->i_aux = rand();
-			m_ucore->i_aux = m_score->i_aux;
+			setaux<C::SAUX>(m_score, m_rng()&1);
+			setaux<C::UAUX>(m_ucore, m_rng()&1);
 		}
 
-#ifdef	ASYNC_RESET
-		m_score->i_areset_n = 0;
-		m_ucore->i_areset_n = 0;
-#else
-		m_score->i_reset = 1;
-		m_ucore->i_reset = 1;
-#endif
+		setreset<C::SASYNC>(m_score, true);
+		setreset<C::UASYNC>(m_ucore, true);
 		tick();
-		m_score->i_aux = 0;
-		m_ucore->i_aux = 0;
-#ifdef	ASYNC_RESET
-		m_score->i_areset_n = 1;
-		m_ucore->i_areset_n = 1;
-#else
-		m_score->i_reset = 0;
-		m_ucore->i_reset = 0;
-#endif
-		m_ssync = false;
-		m_usync = false;
-		m_soff = 0;
-		m_uoff = 0;
+		setreset<C::SASYNC>(m_score, false);
+		setreset<C::UASYNC>(m_ucore, false);
+		m_uchecked = m_schecked = 0;
 
 		m_addr = 0;
 	}
 
-	void	sync(void) {
-		m_score->i_aux = 1;
-		m_ucore->i_aux = 1;
+	//
+	// capture()
+	//
+	// Remember the operands of the last winsz products, so that a failure
+	// can be re-run with tracing turned on
+	void	capture(const int winsz) {
+		m_winsz = winsz;
+		m_window.resize(winsz);
+	}
+
+	//
+	// replay()
+	//
+	// Re-run the last m_winsz products on a fresh copy of each core,
+	// tracing the result
+	void	replay(void) {
+		MPYTB	*rtb = new MPYTB(m_seed);
+		long	first = (m_addr > m_winsz) ? m_addr - m_winsz : 0;
+
+		rtb->m_replay = true;
+		rtb->m_cores = m_cores;
+		rtb->opentrace("fail_%s_%dx%d" TRACE_EXT);
+		rtb->reset();
+
+		// Start from the same index, so that i_aux matches as well
+		rtb->m_addr = first;
+		for(long k=first; k<m_addr; k++) {
+			bool	pass;
+
+			pass = rtb->test(m_window[k % m_winsz].a,
+				m_window[k % m_winsz].b);
+			if ((k+1 == m_addr)&&(pass))
+				printf("WARNING: The failure did not repeat when re-run\n");
+		}
+		delete	rtb;
+
+		printf("The last %ld clocks were written to fail_*mpy_%dx%d" TRACE_EXT "\n",
+			m_addr - first, NA, NB);
+	}
+
+	void	fail(const char *msg) {
+		bool	first = true;
+
+		// Failures while re-running a window are expected--that's the
+		// point
+		if (m_replay)
+			return;
+
+		if (m_report)
+			first = m_report->fail(msg);
+		else
+			printf("%s\n", msg);
+
+		if ((first)&&(m_winsz > 0))
+			replay();
+
+		if (!m_report)
+			exit(EXIT_FAILURE);
+	}
+
+	//
+	// drain()
+	//
+	// Push zeros through the pipeline until every product we've given
+	// the cores so far has been checked.
+	bool	drain(void) {
+		long	last = m_addr;
+
+		for(int k=0; k<ULAT+SLAT; k++) {
+			if (checked() >= last)
+				return true;
+			if (!test(0, 0))
+				return false;
+		}
+
+		fail("ERR: Pipeline never drained");
+		return false;
+	}
+
+	//
+	// checked()
+	//
+	// The number of products checked on every core under test
+	long	checked(void) const {
+		if (m_cores == MPY_UMPY)
+			return m_uchecked;
+		else if (m_cores == MPY_SGNMPY)
+			return m_schecked;
+		return (m_uchecked < m_schecked) ? m_uchecked : m_schecked;
 	}
 
-	bool	test(const int ia, const int ib) {
+	bool	test(const long ia, const long ib) {
 		bool		success;
-		int		aux;
+		bool		aux;
 		long		sout;
 		unsigned long	uout;
+		int		uidx = m_addr % ULAT, sidx = m_addr % SLAT;
+
+		// Scramble the aux bit, so that any misalignment between it and
+		// o_p will show up
+		aux = (((unsigned long)m_addr * 0x9e3779b97f4a7c15ul) >> 63)&1;
+
+		if (m_cores & MPY_SGNMPY) {
+			m_score->i_ce = 1;
+			m_score->i_a = ubits<NA>(ia);
+			m_score->i_b = ubits<NB>(ib);
+			setaux<C::SAUX>(m_score, aux);
+			svals[sidx] = sbits<NA>(ia) * sbits<NB>(ib);
+			m_saux[sidx] = aux;
+		}
 
-		m_score->i_ce = 1;
-		m_ucore->i_ce = 1;
-		m_score->i_a = sbits(ia, NA);
-		m_score->i_b = sbits(ib, NB);
-		m_ucore->i_a = ubits(ia, NA);
-		m_ucore->i_b = ubits(ib, NB);
-		aux = m_ucore->i_aux;
-
-		assert(NA+NB < 8*sizeof(long));
-
-		uvals[m_addr&31] = (unsigned long)ubits(ia, NA)
-					* (unsigned long)ubits(ib, NB);
-		svals[m_addr&31] = (long)sbits(ia, NA)
-					* (long)sbits(ib, NB);
-		/*
-		printf("UVALS[%2x] = %08lx, SVALS[%2x] = %08lx, ia = %d, ib = %d, sia = %d, sib = %d\n",
-			m_addr & 31, uvals[m_addr & 31],
-			m_addr & 31, svals[m_addr & 31],
-			ia, ib,
-			(int)sbits(ia, NA),
-			(int)sbits(ib, NB));
-		*/
+		if (m_cores & MPY_UMPY) {
+			m_ucore->i_ce = 1;
+			m_ucore->i_a = ubits<NA>(ia);
+			m_ucore->i_b = ubits<NB>(ib);
+			setaux<C::UAUX>(m_ucore, aux);
+			uvals[uidx] = ubits<NA>(ia) * ubits<NB>(ib);
+			m_uaux[uidx] = aux;
+		}
+
+		if (m_winsz > 0) {
+			m_window[m_addr % m_winsz].a = ia;
+			m_window[m_addr % m_winsz].b = ib;
+		}
 
 		tick();
 
 		if (trace) {
-		printf("%c%ck=%3d: A =%06x, B =%06x, AUX=%d -> ANS =%10lx, O = %9lx, AUX=%d, S(O) = %9lx, SAUX=%d\n",
-			(m_usync)?'U':' ',
-			(m_ssync)?'S':' ',
-			m_addr, (int)ubits(ia, NA), (int)ubits(ib,NB), aux,
-			ubits(uvals[m_addr&31], NA+NB), // ANS
-			(long)m_ucore->o_p, m_ucore->o_aux,
-			(unsigned long)m_score->o_p, m_score->o_aux);
+		printf("k=%3ld: A =%06x, B =%06x, AUX=%d -> ANS =%10lx, O = %9lx, S(O) = %9lx\n",
+			m_addr, (int)ubits<NA>(ia), (int)ubits<NB>(ib), aux,
+			ubits<NA+NB>(uvals[uidx]), // ANS
+			(long)m_ucore->o_p, (unsigned long)m_score->o_p);
 		}
-		uout = ubits(m_ucore->o_p, NA+NB);
-		sout = sbits(m_score->o_p, NA+NB);
+		uout = ubits<NA+NB>(m_ucore->o_p);
+		sout = sbits<NA+NB>(m_score->o_p);
 
+		// After this clock, o_p holds the result from ULAT-1 products
+		// ago, which is also the oldest product left in our ring.  Until
+		// then, the pipeline holds only what the reset left in it.
 		m_addr++;
-		if ((m_ucore->o_aux)&&(!m_usync)) {
-			printf("Unsigned Sync!\n");
-			m_uoff = m_addr;
-			m_usync = true;
-		}
+		uidx = m_addr % ULAT;
+		sidx = m_addr % SLAT;
 
-		if ((m_score->o_aux)&&(!m_ssync)) {
-			printf("Signed Sync!\n");
-			m_soff = m_addr;
-			m_ssync = true;
-		}
+		if (m_cores & MPY_UMPY) {
+			unsigned long	uexp = (m_addr >= ULAT) ? uvals[uidx] : 0;
 
-		success = true;
-		if (m_usync) {
-			success = success && (uout== uvals[(m_addr-m_uoff)&31]);
+			bool	auxexp = (m_addr >= ULAT) && m_uaux[uidx];
+			int	uaux = getaux<C::UAUX>(m_ucore);
+
+			success = (uout == uexp);
+			if (C::UAUX)
+				success = success && (uaux == auxexp);
 			if (!success) {
-				printf("WRONG U-ANSWER: %8lx != %8lx\n", uvals[(m_addr-m_uoff)&0x01f], uout);
-				exit(EXIT_FAILURE);
+				char	msg[128];
+				if (C::UAUX)
+					sprintf(msg, "WRONG U-ANSWER: %8lx != %8lx, AUX %d != %d", uexp, uout, auxexp, uaux);
+				else
+					sprintf(msg, "WRONG U-ANSWER: %8lx != %8lx", uexp, uout);
+				fail(msg);
+				return false;
 			}
+			if (m_addr >= ULAT)
+				m_uchecked++;
 		}
-		if ((success)&&(m_ssync)) {
-			success = success && (sout== svals[(m_addr-m_soff)&31]);
+
+		if (m_cores & MPY_SGNMPY) {
+			long	sexp = (m_addr >= SLAT) ? svals[sidx] : 0;
+
+			bool	auxexp = (m_addr >= SLAT) && m_saux[sidx];
+			int	saux = getaux<C::SAUX>(m_score);
+
+			success = (sout == sexp);
+			if (C::SAUX)
+				success = success && (saux == auxexp);
 			if (!success) {
-				printf("WRONG SGN-ANSWER: %8lx (expected) != %8lx (actual)\n", svals[(m_addr-m_soff)&0x01f], sout);
-				exit(EXIT_FAILURE);
+				char	msg[128];
+				if (C::SAUX)
+					sprintf(msg, "WRONG SGN-ANSWER: %8lx (expected) != %8lx (actual), AUX %d != %d", sexp, sout, auxexp, saux);
+				else
+					sprintf(msg, "WRONG SGN-ANSWER: %8lx (expected) != %8lx (actual)", sexp, sout);
+				fail(msg);
+				return false;
 			}
+			if (m_addr >= SLAT)
+				m_schecked++;
 		}
 
-		if ((!m_usync)&&(!m_ssync))
-			success = (m_addr < 32);
-		
-		return success;
+		return true;
 	}
 };
 
-int	main(int argc, char **argv, char **envp) {
-	Verilated::commandArgs(argc, argv);
-	MPYTB		*tb = new MPYTB;
+//
+// MPYSHARD
+//
+// One contiguous range of operand indices, [m_lo, m_hi), where the index
+// is given by (a << NB) | b.  Everything below m_unext has been checked on
+// the unsigned core, and everything below m_snext on the signed one.  The
+// two only differ when each core is swept by its own thread.
+//
+class	MPYSHARD {
+public:
+	long			m_lo, m_hi;
+	std::atomic<long>	m_unext, m_snext;
+
+	MPYSHARD(const long lo, const long next, const long hi) {
+		m_lo = lo; m_unext = m_snext = next; m_hi = hi;
+	}
+
+	// Everything below next() has been checked on the given cores
+	long	next(const int cores) const {
+		long	u = m_unext, s = m_snext;
+
+		if (cores == MPY_UMPY)
+			return u;
+		else if (cores == MPY_SGNMPY)
+			return s;
+		return (u < s) ? u : s;
+	}
+
+	void	advance(const int cores, const long next) {
+		if (cores & MPY_UMPY)
+			m_unext = next;
+		if (cores & MPY_SGNMPY)
+			m_snext = next;
+	}
+};
+
+//
+// MPYOPTS
+//
+// The command line options, which are the same for every size
+//
+struct	MPYOPTS {
+	int		nthreads, shard, nshards, winsz, cores;
+	bool		fast;
+	std::string	ckptname;
+};
+
+//
+// sweep()
+//
+// Exhaustively test every operand index within a shard, starting from
+// wherever the shard last left off.
+//
+template<class C> void	sweep(MPYREPORT *rpt, MPYTB<C> *tb, MPYSHARD *shard) {
+	const	long	STEP = 4096;
+	const	long	bmsk = (1l << C::NB)-1;
+	long		first, a0;
+
+	tb->m_report = rpt;
+
+	// Make certain nothing is left in the pipeline from before, so that
+	// the number of products checked from here on tells us exactly how
+	// far through the shard we've gotten
+	if (!tb->drain()) {
+		rpt->stop();
+		return;
+	}
+	first = shard->next(tb->m_cores);
+	a0    = tb->m_addr;
+
+	for(long base=first; base < shard->m_hi; base += STEP) {
+		long	top = (base + STEP < shard->m_hi) ? base+STEP : shard->m_hi;
+		long	checked;
+
+		if (rpt->failed())
+			break;
+		for(long idx=base; idx < top; idx++)
+			// Any mismatch will have already been reported
+			if (!tb->test(idx >> C::NB, idx & bmsk))
+				break;
+		rpt->add(top - base);
+
+		checked = tb->checked();
+		shard->advance(tb->m_cores, first + checked - a0);
+	}
+
+	if ((!rpt->failed())&&(tb->drain()))
+		shard->advance(tb->m_cores, shard->m_hi);
+	rpt->stop();
+}
+
+const char	*corename(const int cores) {
+	if (cores == MPY_UMPY)
+		return "umpy";
+	else if (cores == MPY_SGNMPY)
+		return "sgnmpy";
+	return "umpy and sgnmpy";
+}
+
+//
+// writeckpt()
+//
+// Record our progress.  The file is written under a temporary name and then
+// renamed, so a job killed part way through a write will still leave the
+// last good checkpoint behind.
+//
+void	writeckpt(const char *fname, const int na, const int nb,
+		const int shard, const int nshards, const int cores,
+		const long ulat, const long slat,
+		std::vector<MPYSHARD *> &shards) {
+	std::string	tmpname = std::string(fname) + ".tmp";
+	FILE		*fp;
+
+	fp = fopen(tmpname.c_str(), "w");
+	if (!fp) {
+		fprintf(stderr, "ERR: Could not write checkpoint, %s\n",
+			tmpname.c_str());
+		return;
+	}
+
+	fprintf(fp, "# mpy_tb checkpoint\n");
+	fprintf(fp, "size %dx%d\n", na, nb);
+	fprintf(fp, "shard %d/%d\n", shard, nshards);
+	fprintf(fp, "cores %d\n", cores);
+	fprintf(fp, "latency %ld %ld\n", ulat, slat);
+	for(unsigned k=0; k<shards.size(); k++)
+		fprintf(fp, "range %ld %ld %ld\n", shards[k]->m_lo,
+			shards[k]->next(cores), shards[k]->m_hi);
+	fclose(fp);
+
+	if (rename(tmpname.c_str(), fname) != 0) {
+		fprintf(stderr, "ERR: Could not rename %s\n", tmpname.c_str());
+		perror("O/S Err:");
+	}
+}
+
+//
+// readckpt()
+//
+// Returns true if a checkpoint was found and read.  Any checkpoint that
+// doesn't match this core size, this shard, or these cores, is an error.
+// Checkpoints from before cores could be tested separately covered both.
+//
+bool	readckpt(const char *fname, const int NA, const int NB,
+		const int shard, const int nshards, const int cores,
+		long &ulat, long &slat, std::vector<MPYSHARD *> &shards) {
+	FILE	*fp;
+	char	line[256];
+	int	na = 0, nb = 0, ishard = -1, inshards = -1, icores = MPY_BOTH;
+
+	fp = fopen(fname, "r");
+	if (!fp)
+		return false;
+
+	while(fgets(line, sizeof(line), fp)) {
+		long	lo, next, hi;
+
+		if (line[0] == '#')
+			continue;
+		else if (sscanf(line, "size %dx%d", &na, &nb) == 2)
+			continue;
+		else if (sscanf(line, "shard %d/%d", &ishard, &inshards) == 2)
+			continue;
+		else if (sscanf(line, "cores %d", &icores) == 1)
+			continue;
+		else if (sscanf(line, "latency %ld %ld", &ulat, &slat) == 2)
+			continue;
+		else if (sscanf(line, "range %ld %ld %ld", &lo, &next, &hi) == 3)
+			shards.push_back(new MPYSHARD(lo, next, hi));
+		else {
+			fprintf(stderr, "ERR: Unrecognized checkpoint line, %s", line);
+			exit(EXIT_FAILURE);
+		}
+	} fclose(fp);
+
+	if ((na != NA)||(nb != NB)||(ishard != shard)||(inshards != nshards)
+			||(shards.size() == 0)) {
+		fprintf(stderr, "ERR: Checkpoint %s is for a %dx%d multiply, shard %d/%d\n", fname, na, nb, ishard, inshards);
+		exit(EXIT_FAILURE);
+	} else if (icores != cores) {
+		fprintf(stderr, "ERR: Checkpoint %s is for %s, not %s\n", fname,
+			corename(icores), corename(cores));
+		exit(EXIT_FAILURE);
+	}
+
+	return true;
+}
+
+//
+// runsize()
+//
+// Test one size of multiply: first a handful of directed tests, then the
+// exhaustive sweep.  Returns true on success.
+//
+template<class C> bool	runsize(const MPYOPTS &opts, const char *ckptname) {
+	const int	NA = C::NA, NB = C::NB;
+	MPYTB<C>	*tb = new MPYTB<C>;
+	int		nthreads = opts.nthreads, winsz = opts.winsz;
+	const int	shard = opts.shard, nshards = opts.nshards;
+	const long	total = 1l << (NA+NB);
+	const	int	CKPT_SECONDS = 60;
+	long		ulat = 0, slat = 0;
+	std::vector<MPYSHARD *>	shards;
+
+	if ((ckptname)&&(readckpt(ckptname, NA, NB, shard, nshards,
+				opts.cores, ulat, slat, shards)))
+		printf("Resuming from %s\n", ckptname);
+	else {
+		long	lo = (total * shard) / nshards,
+			hi = (total * (shard+1)) / nshards;
+
+		if (nthreads > hi - lo)
+			nthreads = (int)(hi - lo);
+		for(int k=0; k<nthreads; k++)
+			shards.push_back(new MPYSHARD(
+				lo + ((hi-lo) * k) / nthreads, 
+				lo + ((hi-lo) * k) / nthreads, 
+				lo + ((hi-lo) * (k+1)) / nthreads));
+	}
+	nthreads = shards.size();
+
+	// A core that isn't under test has nothing left to check
+	for(int k=0; k<nthreads; k++)
+		shards[k]->advance(MPY_BOTH & ~opts.cores, shards[k]->m_hi);
+
+	// Any shorter, and a re-run window wouldn't reach back to the product
+	// that failed
+	if ((winsz > 0)&&(winsz < C::SLAT))
+		winsz = C::SLAT;
+	if ((winsz > 0)&&(winsz < C::ULAT))
+		winsz = C::ULAT;
+	if (winsz > 0)
+		tb->capture(winsz);
+	tb->m_cores = opts.cores;
+	tb->m_fast  = opts.fast;
 
 	if (trace)
-		tb->opentrace("trace_%s_%dx%d.vcd");
+		tb->opentrace("trace_%s_%dx%d" TRACE_EXT);
 	tb->reset();
-	tb->sync();
 
 	tb->test(0, 0);
-	tb->test((1<<(NA-1)), 0);
-	tb->test((1<<(NA-1)), (1<<(NB-1)));
-	tb->test(0, (1<<(NB-1)));
+	tb->test((1l<<(NA-1)), 0);
+	tb->test((1l<<(NA-1)), (1l<<(NB-1)));
+	tb->test(0, (1l<<(NB-1)));
 
 	tb->test(0, 0);
-	tb->test((1<<(NA-1))-1, 0);
-	tb->test((1<<(NA-1))-1, (1<<(NB-1))-1);
-	tb->test(0, (1<<(NB-1))-1);
+	tb->test((1l<<(NA-1))-1, 0);
+	tb->test((1l<<(NA-1))-1, (1l<<(NB-1))-1);
+	tb->test(0, (1l<<(NB-1))-1);
 
-	tb->test((1<<(NA-1))  , (1<<(NB-1)));
-	tb->test((1<<(NA-1))-1, (1<<(NB-1)));
-	tb->test((1<<(NA-1))-1, (1<<(NB-1))-1);
-	tb->test((1<<(NA-1))  , (1<<(NB-1))-1);
+	tb->test((1l<<(NA-1))  , (1l<<(NB-1)));
+	tb->test((1l<<(NA-1))-1, (1l<<(NB-1)));
+	tb->test((1l<<(NA-1))-1, (1l<<(NB-1))-1);
+	tb->test((1l<<(NA-1))  , (1l<<(NB-1))-1);
 
-	tb->sync();
 	for(int k=0; k<(NA-1); k++) {
-		int	a, b;
+		long	a, b;
 
-		a = (1<<k);
+		a = (1l<<k);
 		b = 1;
 		tb->test(a, b);
 	}
 
 	for(int k=0; k<(NB-1); k++) {
-		int	a, b;
+		long	a, b;
 
-		a = (1<<15);
-		b = (1<<k);
+		a = (1l<<15);
+		b = (1l<<k);
 		tb->test(a, b);
 	}
 
 	for(int k=0; k<1024; k++)
 		tb->test(rand(), rand());
 
-	for(int k=0; k<(1<<NA); k++) {
-		for(int j=0; j<(1<<NB); j++) {
-			tb->test(k, j);
+	// If we are resuming, the cores had better have the same latency they
+	// had before
+	if ((ulat != 0)&&((ulat != C::ULAT)||(slat != C::SLAT))) {
+		fprintf(stderr, "ERR: Core latency (%d,%d) doesn't match the checkpoint (%ld,%ld)\n",
+			C::ULAT, C::SLAT, ulat, slat);
+		exit(EXIT_FAILURE);
+	}
+	ulat = C::ULAT;
+	slat = C::SLAT;
+
+	// In fast mode, the signed and unsigned cores get a thread each
+	// rather than being evaluated one after the other on the same
+	// thread--so long as there are enough CPUs to run them all at once
+	const bool	split = (opts.fast)&&(opts.cores == MPY_BOTH)
+			&&(2u*nthreads <= std::thread::hardware_concurrency());
+	std::vector<MPYTB<C> *>		tbs;
+	std::vector<MPYSHARD *>		tbshards;
+	std::vector<std::thread>	workers;
+
+	// Set every copy up from this thread first.  Our first copy has already
+	// been through the directed tests above, and each of the others gets a
+	// generator seeded from its shard.
+	for(int k=0; k<nthreads; k++) {
+		for(int c=0; c<(split ? 2:1); c++) {
+			MPYTB<C>	*wtb = tb;
+
+			if (tbs.size() > 0) {
+				wtb = new MPYTB<C>(k+1);
+				if (winsz > 0)
+					wtb->capture(winsz);
+				wtb->m_fast = opts.fast;
+				wtb->reset();
+			}
+			wtb->m_cores = (!split) ? opts.cores
+					: (c == 0) ? MPY_UMPY : MPY_SGNMPY;
+			tbs.push_back(wtb);
+			tbshards.push_back(shards[k]);
 		}
 	}
 
+	long	remaining = 0;
+	for(unsigned k=0; k<tbs.size(); k++)
+		remaining += tbshards[k]->m_hi
+				- tbshards[k]->next(tbs[k]->m_cores);
+
+	MPYREPORT	rpt(remaining);
+
+	for(unsigned k=0; k<tbs.size(); k++) {
+		rpt.start();
+		workers.push_back(std::thread(sweep<C>, &rpt, tbs[k],
+				tbshards[k]));
+	}
+
+	{
+		time_t	last = time(NULL);
+
+		while(rpt.active()) {
+			sleep(1);
+			rpt.progress();
+
+			if ((ckptname)&&(!rpt.failed())
+					&&(time(NULL) - last >= CKPT_SECONDS)) {
+				writeckpt(ckptname, NA, NB, shard, nshards,
+					opts.cores, ulat, slat, shards);
+				last = time(NULL);
+			}
+		}
+	}
+
+	for(unsigned k=0; k<workers.size(); k++)
+		workers[k].join();
+	if ((ckptname)&&(!rpt.failed()))
+		writeckpt(ckptname, NA, NB, shard, nshards, opts.cores,
+			ulat, slat, shards);
+	for(unsigned k=1; k<tbs.size(); k++)
+		delete tbs[k];
+	for(int k=0; k<nthreads; k++)
+		delete shards[k];
 	delete	tb;
 
+	return !rpt.failed();
+}
+
+//
+// The registry of every size this test bench was built with
+//
+struct	MPYENTRY {
+	const char	*name;
+	bool		(*run)(const MPYOPTS &, const char *);
+};
+
+#define	MPYSIZE(SZ, A, B)	{ #SZ, runsize<MPYCAT(MPYCORE_, SZ, )> },
+static const MPYENTRY	mpyregistry[] = {
+#include "mpysizes.h"
+	{ NULL, NULL }
+};
+#undef	MPYSIZE
+
+void	usage(void) {
+	fprintf(stderr, "USAGE: mpy_tb [--size <NxM>[,<NxM>...]]"
+		" [--only umpy|sgnmpy] [--fast] [-j <nthreads>]\n"
+		"\t[--shard <i>/<n>] [--checkpoint <file>] [-w <window>]\n");
+	fprintf(stderr, "\tSizes:");
+	for(int k=0; mpyregistry[k].name; k++)
+		fprintf(stderr, " %s", mpyregistry[k].name);
+	fprintf(stderr, "\n");
+}
+
+int	main(int argc, char **argv, char **envp) {
+	Verilated::commandArgs(argc, argv);
+	MPYOPTS		opts;
+	std::vector<const MPYENTRY *>	sizes;
+	const char	*sizelist = NULL;
+
+	opts.nthreads = 1;
+	opts.shard    = 0;
+	opts.nshards  = 1;
+	opts.winsz    = 0;
+	opts.cores    = MPY_BOTH;
+	opts.fast     = false;
+
+	{ int c;
+	static const struct option	long_options[] = {
+		{ "threads",	required_argument, NULL, 'j' },
+		{ "shard",	required_argument, NULL, 's' },
+		{ "checkpoint",	required_argument, NULL, 'c' },
+		{ "window",	required_argument, NULL, 'w' },
+		{ "size",	required_argument, NULL, 'z' },
+		{ "only",	required_argument, NULL, 'o' },
+		{ "fast",	no_argument,	   NULL, 'f' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	while((c = getopt_long(argc, argv, "c:fj:o:s:w:z:", long_options,
+			NULL)) != -1) {
+		switch(c) {
+		case 'c':	opts.ckptname = optarg; break;
+		case 'f':	opts.fast = true; break;
+		case 'o':
+			if (strcmp(optarg, "umpy") == 0)
+				opts.cores = MPY_UMPY;
+			else if (strcmp(optarg, "sgnmpy") == 0)
+				opts.cores = MPY_SGNMPY;
+			else {
+				fprintf(stderr, "ERR: Unknown core, %s\n", optarg);
+				usage();
+				exit(EXIT_FAILURE);
+			} break;
+		case 'j':	opts.nthreads = atoi(optarg); break;
+		case 'w':	opts.winsz = atoi(optarg); break;
+		case 'z':	sizelist = optarg; break;
+		case 's':
+			if ((sscanf(optarg, "%d/%d", &opts.shard, &opts.nshards) != 2)
+				||(opts.nshards < 1)||(opts.shard < 0)
+				||(opts.shard >= opts.nshards)) {
+				fprintf(stderr, "ERR: Bad shard, %s\n", optarg);
+				exit(EXIT_FAILURE);
+			} break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}}
+
+	if (opts.nthreads <= 0)
+		opts.nthreads = std::thread::hardware_concurrency();
+	if (opts.nthreads <= 0)
+		opts.nthreads = 1;
+
+	if (sizelist) {
+		std::string	list = sizelist;
+		size_t		pos = 0;
+
+		while(pos <= list.size()) {
+			size_t		end = list.find(',', pos);
+			std::string	name;
+			int		k;
+
+			if (end == std::string::npos)
+				end = list.size();
+			name = list.substr(pos, end-pos);
+			for(k=0; mpyregistry[k].name; k++)
+				if (name == mpyregistry[k].name)
+					break;
+			if (!mpyregistry[k].name) {
+				fprintf(stderr, "ERR: No %s multiply was built\n",
+					name.c_str());
+				usage();
+				exit(EXIT_FAILURE);
+			}
+			sizes.push_back(&mpyregistry[k]);
+			pos = end+1;
+		}
+	} else for(int k=0; mpyregistry[k].name; k++)
+		sizes.push_back(&mpyregistry[k]);
+
+	if (sizes.size() == 0) {
+		fprintf(stderr, "ERR: No multiplies to test\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(unsigned k=0; k<sizes.size(); k++) {
+		std::string	ckpt = opts.ckptname;
+
+		if ((ckpt.size() > 0)&&(sizes.size() > 1))
+			ckpt += std::string(".") + sizes[k]->name;
+
+		printf("Testing the %s multiplies\n", sizes[k]->name);
+		if (!sizes[k]->run(opts, (ckpt.size() > 0)
+						? ckpt.c_str() : NULL))
+			exit(EXIT_FAILURE);
+	}
+
 	printf("SUCCESS!\n");
 	exit(0);
 }
-
@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	mpybench.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	Measures how fast each generated core simulates, so that
+//		changes to bldmpy's output, to the Verilator flags, or to the
+//	test benches can be compared from one commit to the next.
+//
+//	Every umpy and sgnmpy core in mpysizes.h is run for a fixed number of
+//	clocks (-c), both as a Verilated model and as the C++ model bldmpy
+//	writes for it, and so is slowmpy if it has been Verilated.  The
+//	results are written as JSON (to -o <file>, or stdout), giving the
+//	simulated clocks per second, products per second, eval() calls per
+//	clock, and host nanoseconds per product of each.
+//
+//	-b <file> compares the results against those of an earlier run, and
+//	fails if any core has slowed by more than -t <percent> (10 by
+//	default).
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015,2018-2019, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "verilated.h"
+#include "mpycores.h"
+
+#if	__has_include("Vslowmpy.h")
+#include "Vslowmpy.h"
+#define	HAVE_SLOWMPY
+#endif
+
+//
+// BENCHRESULT
+//
+// What we learned from running one model.  Widths of zero are unknown.
+//
+struct	BENCHRESULT {
+	std::string	core, model;
+	int		na, nb;
+	long		cycles, products, evals;
+	double		seconds;
+
+	double	cycles_per_sec(void) const { return cycles / seconds; }
+	double	mpys_per_sec(void) const { return products / seconds; }
+	double	evals_per_cycle(void) const { return (double)evals / cycles; }
+	double	ns_per_product(void) const {
+		return (products > 0) ? (1e9 * seconds) / products : 0.0;
+	}
+};
+
+// Keeps the compiler from optimizing any model away
+volatile unsigned long	sink;
+
+// The operands, drawn up front so rand() isn't part of what we measure
+static const int	NOPS = 4096;
+static unsigned long	opa[NOPS], opb[NOPS];
+
+//
+// tick()
+//
+// The same clock the test benches use, counting every eval() it takes
+template<class V> static inline void	tick(V *core, long &evals) {
+	core->i_clk = 0;
+	core->eval();
+	core->i_clk = 1;
+	core->eval();
+	core->i_clk = 0;
+	core->eval();
+	evals += 3;
+}
+
+//
+// benchpipe()
+//
+// Run one pipelined core, with i_ce held high, for the given number of
+// clocks.  Every clock then starts one product.
+template<class V, int NA, int NB, bool AUX, bool ASYNC>
+BENCHRESULT	benchpipe(const char *core, const char *model, const char *sz,
+		const long cycles) {
+	V		*c = new V;
+	BENCHRESULT	r;
+	long		evals = 0;
+	unsigned long	chk = 0;
+
+	c->i_ce = 1;
+	c->i_a = 0;
+	c->i_b = 0;
+	setaux<AUX>(c, 0);
+	setreset<ASYNC>(c, true);
+	tick(c, evals);
+	setreset<ASYNC>(c, false);
+	evals = 0;
+
+	auto	start = std::chrono::steady_clock::now();
+	for(long k=0; k<cycles; k++) {
+		c->i_a = ubits<NA>(opa[k & (NOPS-1)]);
+		c->i_b = ubits<NB>(opb[k & (NOPS-1)]);
+		setaux<AUX>(c, k&1);
+		tick(c, evals);
+		chk += c->o_p;
+	}
+	auto	stop = std::chrono::steady_clock::now();
+
+	c->final();
+	delete c;
+	sink = chk;
+
+	r.core = std::string(core) + "_" + sz;
+	r.model = model;
+	r.na = NA;
+	r.nb = NB;
+	r.cycles = cycles;
+	r.products = cycles;
+	r.evals = evals;
+	r.seconds = std::chrono::duration<double>(stop - start).count();
+	return r;
+}
+
+//
+// benchsize()
+//
+// Run all four models of one size, or just the two Verilated ones if bldmpy
+// didn't write C++ models of it
+template<class C> void	benchsize(const char *sz, const long cycles,
+		std::vector<BENCHRESULT> &results) {
+	results.push_back(benchpipe<typename C::VUMPY, C::NA, C::NB,
+		C::UAUX, C::UASYNC>("umpy", "verilator", sz, cycles));
+	results.push_back(benchpipe<typename C::VSGN, C::NA, C::NB,
+		C::SAUX, C::SASYNC>("sgnmpy", "verilator", sz, cycles));
+	if constexpr (C::HAS_CMODEL) {
+		results.push_back(benchpipe<typename C::CUMPY, C::NA, C::NB,
+			C::UAUX, C::UASYNC>("umpy", "native", sz, cycles));
+		results.push_back(benchpipe<typename C::CSGN, C::NA, C::NB,
+			C::SAUX, C::SASYNC>("sgnmpy", "native", sz, cycles));
+	}
+}
+
+#ifdef	HAVE_SLOWMPY
+//
+// benchslow()
+//
+// slowmpy takes one product at a time, so a new one is started whenever
+// it isn't busy, and the products are counted as they finish
+BENCHRESULT	benchslow(const long cycles) {
+	Vslowmpy	*c = new Vslowmpy;
+	BENCHRESULT	r;
+	long		evals = 0, products = 0;
+	unsigned long	chk = 0;
+
+	c->i_stb = 0;
+	c->i_aux = 0;
+	c->i_reset = 1;
+	tick(c, evals);
+	c->i_reset = 0;
+	evals = 0;
+
+	auto	start = std::chrono::steady_clock::now();
+	for(long k=0; k<cycles; k++) {
+		c->i_stb = !c->o_busy;
+		c->i_a_unsorted = opa[k & (NOPS-1)];
+		c->i_b_unsorted = opb[k & (NOPS-1)];
+		tick(c, evals);
+		if (c->o_done) {
+			products++;
+			chk += c->o_p;
+		}
+	}
+	auto	stop = std::chrono::steady_clock::now();
+
+	c->final();
+	delete c;
+	sink = chk;
+
+	r.core = "slowmpy";
+	r.model = "verilator";
+	r.na = r.nb = 0;
+	r.cycles = cycles;
+	r.products = products;
+	r.evals = evals;
+	r.seconds = std::chrono::duration<double>(stop - start).count();
+	return r;
+}
+#endif
+
+void	writejson(FILE *fp, const long cycles,
+		const std::vector<BENCHRESULT> &results) {
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"cycles\": %ld,\n", cycles);
+	fprintf(fp, "\t\"results\": [\n");
+	// One result per line, so compare() needn't be a JSON parser
+	for(unsigned k=0; k<results.size(); k++) {
+		const BENCHRESULT	&r = results[k];
+
+		fprintf(fp, "\t\t{ \"core\": \"%s\", \"model\": \"%s\", ",
+			r.core.c_str(), r.model.c_str());
+		if (r.na > 0)
+			fprintf(fp, "\"na\": %d, \"nb\": %d, ", r.na, r.nb);
+		fprintf(fp, "\"cycles\": %ld, \"products\": %ld, "
+			"\"seconds\": %.6f, \"cycles_per_sec\": %.1f, "
+			"\"mpys_per_sec\": %.1f, \"evals_per_cycle\": %.2f, "
+			"\"ns_per_product\": %.3f }%s\n",
+			r.cycles, r.products, r.seconds,
+			r.cycles_per_sec(), r.mpys_per_sec(),
+			r.evals_per_cycle(), r.ns_per_product(),
+			(k+1 < results.size()) ? ",":"");
+	}
+	fprintf(fp, "\t]\n");
+	fprintf(fp, "}\n");
+}
+
+//
+// compare()
+//
+// Compare against the ns_per_product of an earlier run, as written by
+// writejson().  Returns false if anything got slower by more than
+// threshold percent.
+bool	compare(const char *fname, const double threshold,
+		const std::vector<BENCHRESULT> &results) {
+	FILE	*fp;
+	char	line[1024];
+	bool	pass = true;
+
+	fp = fopen(fname, "r");
+	if (!fp) {
+		fprintf(stderr, "ERR: Could not open %s\n", fname);
+		perror("O/S Err:");
+		exit(EXIT_FAILURE);
+	}
+
+	while(fgets(line, sizeof(line), fp)) {
+		char	core[64], model[64];
+		const char	*ptr;
+		double	oldns, pct;
+
+		if (!(ptr = strstr(line, "\"core\":"))
+			||(sscanf(ptr, "\"core\": \"%63[^\"]\", \"model\": \"%63[^\"]\"",
+					core, model) != 2)
+			||!(ptr = strstr(line, "\"ns_per_product\":"))
+			||(sscanf(ptr, "\"ns_per_product\": %lf", &oldns) != 1))
+			continue;
+
+		for(unsigned k=0; k<results.size(); k++) {
+			if ((results[k].core != core)||(results[k].model != model)
+					||(oldns <= 0.0))
+				continue;
+
+			pct = 100.0 * (results[k].ns_per_product() - oldns) / oldns;
+			fprintf(stderr, "%-20s %-10s %10.3f ns -> %10.3f ns  %+6.1f%%%s\n",
+				core, model, oldns, results[k].ns_per_product(),
+				pct, (pct > threshold) ? "  SLOWER":"");
+			if (pct > threshold)
+				pass = false;
+		}
+	} fclose(fp);
+
+	return pass;
+}
+
+void	usage(void) {
+	fprintf(stderr, "USAGE: mpybench [-c <clocks>] [-o <file.json>] [-b <baseline.json>] [-t <percent>]\n");
+}
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	long		cycles = 1000000;
+	const char	*outname = NULL, *baseline = NULL;
+	double		threshold = 10.0;
+	std::vector<BENCHRESULT>	results;
+	int		c;
+
+	while((c = getopt(argc, argv, "b:c:o:t:")) != -1) {
+		switch(c) {
+		case 'b':	baseline = optarg; break;
+		case 'c':	cycles = atol(optarg); break;
+		case 'o':	outname = optarg; break;
+		case 't':	threshold = atof(optarg); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (cycles <= 0) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	for(int k=0; k<NOPS; k++) {
+		opa[k] = ((unsigned long)rand() << 31) ^ rand();
+		opb[k] = ((unsigned long)rand() << 31) ^ rand();
+	}
+
+#define	MPYSIZE(SZ, A, B)	\
+	benchsize<MPYCAT(MPYCORE_, SZ, )>(#SZ, cycles, results);
+#include "mpysizes.h"
+#undef	MPYSIZE
+
+#ifdef	HAVE_SLOWMPY
+	results.push_back(benchslow(cycles));
+#endif
+
+	if (outname) {
+		FILE	*fp = fopen(outname, "w");
+
+		if (!fp) {
+			fprintf(stderr, "ERR: Could not open %s\n", outname);
+			perror("O/S Err:");
+			exit(EXIT_FAILURE);
+		}
+		writejson(fp, cycles, results);
+		fclose(fp);
+	} else
+		writejson(stdout, cycles, results);
+
+	if ((baseline)&&(!compare(baseline, threshold, results)))
+		exit(EXIT_FAILURE);
+
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	mpycores.h
+//
+// Project:	A multiply core generator
+//
+// Purpose:	Describes every size of multiply the test benches were built
+//		with, from the list in mpysizes.h, together with a few
+//	helpers for driving cores whatever options bldmpy built them with.
+//	The test benches of the other cores use just the helpers.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015,2018-2019, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	MPYCORES_H
+#define	MPYCORES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "verilated.h"
+
+#define	MPYCAT_(A,B,C)	A ## B ## C
+#define	MPYCAT(A,B,C)	MPYCAT_(A,B,C)
+
+// Clocks from i_a and i_b to o_p, as the test benches see them.  They read
+// o_p after each clock, by which time a core without any registers (a delay
+// of zero) holds the same product as one with a delay of one.
+#define	MPYCLOCKS(D)	(((D) > 0) ? (D) : 1)
+
+template<int N> constexpr unsigned long	ubits(const unsigned long val) {
+	if constexpr (N >= 64)
+		return val;
+	else
+		return val & ((1ul << N)-1);
+}
+
+// The same, for widths that are only known at run time
+static inline unsigned long	ubits(const unsigned long val, const int n) {
+	return (n >= 64) ? val : (val & ((1ul << n)-1));
+}
+
+// Sign extend from N bits, without a branch
+template<int N> constexpr long	sbits(const long val) {
+	return (long)(ubits<N>(val) ^ (1ul << (N-1))) - (1l << (N-1));
+}
+
+// A random N bit operand.  rand() only gives 31 bits at a time.
+template<int N> unsigned long	urand(void) {
+	unsigned long	r = ((unsigned long)rand() << 62)
+			^ ((unsigned long)rand() << 31) ^ rand();
+
+	return ubits<N>(r);
+}
+
+//
+// Set the aux and reset inputs of a core, if it has them, so that the same
+// test bench code works whichever options bldmpy was given
+//
+template<bool AUX, class V> void	setaux(V *core, const int aux) {
+	if constexpr (AUX)
+		core->i_aux = aux;
+}
+
+template<bool AUX, class V> int	getaux(V *core) {
+	if constexpr (AUX)
+		return core->o_aux;
+	else
+		return 0;
+}
+
+template<bool ASYNC, class V> void	setreset(V *core, const bool reset) {
+	if constexpr (ASYNC)
+		core->i_areset_n = !reset;
+	else
+		core->i_reset = reset;
+}
+
+//
+// tick()
+//
+// The two eval() calls Verilator needs to see a rising edge.  Outputs are
+// read with the clock still high.
+template<class V> static inline void	tick(V *core) {
+	core->i_clk = 0;
+	core->eval();
+	core->i_clk = 1;
+	core->eval();
+}
+
+//
+// dropce()
+//
+// Whether to drop i_ce ahead of the next clock.  The test benches do so about
+// a quarter of the time, with other inputs that the core mustn't pick up, to
+// check that it holds its outputs until i_ce returns.
+static inline bool	dropce(void) {
+	return (rand() & 3) == 0;
+}
+
+//
+// MPYPIPE
+//
+// Follows one core along: what was given to it on each of its last DLY
+// clocks, and which of those its outputs come from, once there is one.  T is
+// whatever a test bench needs to check those outputs against.
+//
+template<class T, int DLY> struct	MPYPIPE {
+	T	m_given[DLY];
+	int	m_last;
+
+	MPYPIPE(void) {
+		m_last = -1;
+	}
+
+	// What was given on clock n, with i_ce high
+	void	given(const long n, const T &v) {
+		m_given[n % DLY] = v;
+	}
+
+	// After clock n, the outputs come from what was given DLY-1 clocks ago
+	void	ready(const long n) {
+		if (n+1 >= DLY)
+			m_last = (n+1) % DLY;
+	}
+
+	bool	valid(void) const {
+		return m_last >= 0;
+	}
+
+	const T	&last(void) const {
+		return m_given[m_last];
+	}
+};
+
+//
+// Lane access, for cores that pack several values side by side into one
+// port.  Verilator gives ports of 64-bits or less as integers, and anything
+// wider as an array of 32-bit words.  The integer versions are overloads,
+// so they're picked ahead of the array templates whenever they fit.
+template<class W> static inline void	clrbits(W &w) {
+	memset(&w, 0, sizeof(w));
+}
+
+template<class W> static inline void	orbits(W &w, const int lsb,
+		const int n, const unsigned long v) {
+	for(int k=0; k<n; ) {
+		int	pos = lsb+k, sh = pos&31;
+
+		w[pos>>5] |= (uint32_t)((v >> k) << sh);
+		k += 32-sh;
+	}
+}
+
+template<class W> static inline unsigned long	getbits(const W &w,
+		const int lsb, const int n) {
+	unsigned long	v = 0;
+
+	for(int k=0; k<n; ) {
+		int	pos = lsb+k, sh = pos&31;
+
+		v |= (unsigned long)(w[pos>>5] >> sh) << k;
+		k += 32-sh;
+	}
+	return ubits(v, n);
+}
+
+#define	INTLANES(T)							\
+static inline void	clrbits(T &w) { w = 0; }				\
+static inline void	orbits(T &w, const int lsb, const int,		\
+		const unsigned long v) { w |= (T)(v << lsb); }		\
+static inline unsigned long	getbits(const T &w, const int lsb,	\
+		const int n) { return ubits((unsigned long)(w >> lsb), n); }
+INTLANES(CData)
+INTLANES(SData)
+INTLANES(IData)
+INTLANES(QData)
+#undef	INTLANES
+
+//
+// MPYTBCORE
+//
+// Describes one core to runbench(): its Verilated class, V, the options
+// DESC(...) gives it in its description, whether it's the signed one of a
+// pair, and a name to report failures by
+#define	MPYTBCORE(CORE, VCLASS, DESC, SIGNED, NM)			\
+struct	CORE {								\
+	typedef	VCLASS	V;						\
+	static const int	LAT = MPYCLOCKS(DESC(_DELAY));		\
+	static const bool	AUX = DESC(_AUX),			\
+				ASYNC = DESC(_ASYNC_RESET),		\
+				SGN = SIGNED;				\
+	static constexpr const char	*NAME = NM;			\
+};
+
+// Check the outputs of core C after a clock.  Until anything given to it has
+// come through, CHECK gets a NULL in place of what was given, and should
+// check the core is still as its reset left it.
+template<class C, class CHECK, class P> bool	mpycheck(typename C::V *core,
+		CHECK &chk, const P &pipe) {
+	if (!pipe.valid())
+		return chk.template check<C>(core, NULL);
+	if (!chk.template check<C>(core, &pipe.last()))
+		return false;
+	if ((C::AUX)&&(getaux<C::AUX>(core) != pipe.last().aux)) {
+		printf("WRONG %s-AUX: %d, not %d\n", C::NAME,
+			getaux<C::AUX>(core), pipe.last().aux);
+		return false;
+	}
+	return true;
+}
+
+//
+// runbench()
+//
+// What every test bench of a pipelined core does: reset core C, then give it
+// the inputs STIM gives for each of total clocks, and for as many more as it
+// takes to get them all through.  i_ce drops about a quarter of the time,
+// with other inputs that mustn't get through, and i_aux is random
+// throughout.  CHECK checks the outputs after every clock.  Any failure ends
+// the test.
+//
+// STIM::IN holds what's given on one clock, including its aux bit.
+// stim.given(n, in) fills in clock n, stim.idle(in) the inputs while i_ce is
+// low, and stim.apply(core, in) gives them to the core.
+//
+template<class C, class STIM, class CHECK> void	runbench(STIM &stim,
+		CHECK &chk, const long total) {
+	typedef	typename STIM::IN	IN;
+	typename C::V		*core = new typename C::V;
+	MPYPIPE<IN, C::LAT>	pipe;
+	IN			in = IN();
+	bool			pass;
+
+	core->i_ce = 1;
+	stim.apply(core, in);
+	setaux<C::AUX>(core, 0);
+	setreset<C::ASYNC>(core, true);
+	tick(core);
+	setreset<C::ASYNC>(core, false);
+	pass = mpycheck<C>(core, chk, pipe);
+
+	for(long n=0; (pass)&&(n < total + C::LAT - 1); n++) {
+		while((pass)&&(dropce())) {
+			IN	x = IN();
+
+			stim.idle(x);
+			core->i_ce = 0;
+			stim.apply(core, x);
+			setaux<C::AUX>(core, rand() & 1);
+			tick(core);
+			pass = mpycheck<C>(core, chk, pipe);
+		}
+
+		stim.given(n, in);
+		in.aux = rand() & 1;
+		core->i_ce = 1;
+		stim.apply(core, in);
+		setaux<C::AUX>(core, in.aux);
+		pipe.given(n, in);
+		tick(core);
+
+		pipe.ready(n);
+		pass = (pass)&&(mpycheck<C>(core, chk, pipe));
+	}
+
+	core->final();
+	delete core;
+
+	if (!pass) {
+		printf("TEST FAILED\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+// The test benches of a single core define MPYHELPERS_ONLY, to use the
+// helpers above without every size mpy_tb is built with
+#ifndef	MPYHELPERS_ONLY
+#include "components.h"
+
+//
+// MPYCORE_NxM
+//
+// Everything the test benches need to know about one size: the two
+// Verilated cores, their C++ models, and the properties bldmpy gave them
+// in their descriptions.  There's one of these for every MPYSIZE() in
+// mpysizes.h.  The C++ models are only declared here, since bldmpy doesn't
+// write them for every size--use them only if HAS_CMODEL.
+#define	MPYSIZE(SZ, A, B)						\
+class	MPYCAT(Csgnmpy_, SZ, );						\
+class	MPYCAT(Cumpy_, SZ, );						\
+struct	MPYCAT(MPYCORE_, SZ, ) {					\
+	typedef	MPYCAT(Vsgnmpy_, SZ, )	VSGN;				\
+	typedef	MPYCAT(Vumpy_, SZ, )	VUMPY;				\
+	typedef	MPYCAT(Csgnmpy_, SZ, )	CSGN;				\
+	typedef	MPYCAT(Cumpy_, SZ, )	CUMPY;				\
+	static const int	NA = A, NB = B;				\
+	static const int						\
+		ULAT = MPYCLOCKS(MPYCAT(UMPY_, SZ, _DELAY)),		\
+		SLAT = MPYCLOCKS(MPYCAT(SGNMPY_, SZ, _DELAY));		\
+	static const bool	UAUX = MPYCAT(UMPY_, SZ, _AUX),		\
+				SAUX = MPYCAT(SGNMPY_, SZ, _AUX),	\
+		UASYNC = MPYCAT(UMPY_, SZ, _ASYNC_RESET),		\
+		SASYNC = MPYCAT(SGNMPY_, SZ, _ASYNC_RESET),		\
+		HAS_CMODEL = MPYCAT(UMPY_, SZ, _HAS_CMODEL);		\
+	static_assert((MPYCAT(UMPY_, SZ, _NA) == A)			\
+			&&(MPYCAT(UMPY_, SZ, _NB) == B),		\
+		"The unsigned core doesn't match its size");		\
+	static_assert((MPYCAT(SGNMPY_, SZ, _NA) == A)			\
+			&&(MPYCAT(SGNMPY_, SZ, _NB) == B),		\
+		"The signed core doesn't match its size");		\
+};
+#include "mpysizes.h"
+#undef	MPYSIZE
+
+#endif	// MPYHELPERS_ONLY
+
+#endif	// MPYCORES_H
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	premul_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	An exhaustive test bench for the premul3 and premul4
+//		sub-multipliers that bldmpy -m 3 (or -m 4) builds its tableau
+//	from.  Every i_a is tried against every i_b, with i_ce dropped about a
+//	quarter of the time to check that o_r holds, and the product checked
+//	on the clock after.  Which sub-multiplier is tested depends upon the
+//	PREMUL (Verilated model), LUTB (its width), and ASYNC_RESET macros,
+//	which the mkpremulN.mk that bldmpy writes gives.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "verilated.h"
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(PREMUL.h)
+
+// The width of i_b.  rtl/Makefile Verilates each sub-multiplier on its own,
+// with its default BW parameter.
+const	int	BW = 18;
+const	bool	ASYNC = (ASYNC_RESET != 0);
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	PREMUL		*m = new PREMUL;
+	unsigned long	last;
+
+	m->i_ce = 1;
+	m->i_a = ubits<LUTB>(rand());
+	m->i_b = ubits<BW>(rand());
+	setreset<ASYNC>(m, true);
+	tick(m);
+	setreset<ASYNC>(m, false);
+	if (m->o_r != 0) {
+		printf("RESET FAILED: o_r = %lx\n", (unsigned long)m->o_r);
+		printf("TEST FAILED\n");
+		exit(EXIT_FAILURE);
+	}
+
+	last = 0;
+	for(unsigned long a=0; a < (1ul<<LUTB); a++) {
+		for(unsigned long b=0; b < (1ul<<BW); b++) {
+			// Drop i_ce about a quarter of the time, with
+			// different operands that o_r mustn't pick up
+			while(dropce()) {
+				m->i_ce = 0;
+				m->i_a = ubits<LUTB>(rand());
+				m->i_b = ubits<BW>(rand());
+				tick(m);
+				if (m->o_r != last) {
+					printf("HOLD FAILED: o_r = %lx, not %lx\n",
+						(unsigned long)m->o_r, last);
+					printf("TEST FAILED\n");
+					exit(EXIT_FAILURE);
+				}
+			}
+
+			m->i_ce = 1;
+			m->i_a = a;
+			m->i_b = b;
+			tick(m);
+
+			last = a * b;
+			if (m->o_r != last) {
+				printf("%lx * %lx = %lx, not %lx\n", a, b,
+					(unsigned long)m->o_r, last);
+				printf("TEST FAILED\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	delete	m;
+
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
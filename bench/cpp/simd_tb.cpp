@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	simd_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	A test bench for the packed SIMD multiply cores written by
+//		"bldmpy --simd <bits>".  Every value of i_mode is tried, one
+//	beyond the narrowest lanes included, along with every i_a and i_b when
+//	there are few enough of them.  Otherwise the extremes of each operand
+//	are tried against each other, followed by a million random operands
+//	and modes.  i_ce is dropped about a quarter of the time to check that
+//	o_p and o_aux hold, and every lane of o_p is checked against the
+//	product of its lanes of i_a and i_b, found the simple way.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(SIMD.h)
+#include PMSTR(SIMDH.h)
+
+#define	SDESC(X)	MPYCAT(USIMD_, MPYSZ, X)
+
+static const int	N = SDESC(_N), NP = SDESC(_NP),
+			NMODES = SDESC(_MODES), MBITS = SDESC(_MODE_BITS);
+
+static_assert(NP <= 64, "The products must fit in an unsigned long");
+
+MPYTBCORE(SCORE, SIMD, SDESC, false, "SIMD")
+
+// Bits of the operands and mode, all together, beyond which the sweep is no
+// longer exhaustive
+static const int	MAXEXHAUSTIVE = 24;
+static const long	NRANDOM = 1000000;
+static const bool	exhaustive = (2*N + MBITS <= MAXEXHAUSTIVE);
+static const long	nextreme = (1l << MBITS) * 5 * 5,
+			total = (exhaustive) ? (1l << (2*N + MBITS))
+				: (nextreme + NRANDOM);
+static const unsigned long	ext[5] = { 0, 1, ubits<N>(-1l),
+					1ul << (N-1), ubits<N-1>(-1l) };
+
+// Each lane of a times the same lane of b, side by side, for lanes of N bits
+// in mode zero, N/2 in mode one, and so on down to the narrowest
+unsigned long	lanes(const int mode, const unsigned long a,
+			const unsigned long b) {
+	const int	w = N >> ((mode < NMODES) ? mode : (NMODES-1));
+	unsigned long	p = 0;
+
+	for(int k=0; k<N; k+=w)
+		p |= (ubits(a >> k, w) * ubits(b >> k, w)) << (2*k);
+	return p;
+}
+
+// The mode and operands given on one clock
+struct	SIMDIN {
+	unsigned long	a, b;
+	int		mode, aux;
+};
+
+//
+// SIMDSTIM
+//
+// Every mode and pair of operands in turn, if there aren't too many.
+// Otherwise, every mode with every combination of extreme operands, followed
+// by random ones.
+//
+struct	SIMDSTIM {
+	typedef	SIMDIN	IN;
+
+	void	given(const long n, SIMDIN &in) {
+		if (n >= total) {
+			in.mode = 0;
+			in.a = in.b = 0;
+		} else if (exhaustive) {
+			in.mode = (int)((n >> N) >> N);
+			in.a = ubits<N>(n >> N);
+			in.b = ubits<N>(n);
+		} else if (n < nextreme) {
+			in.mode = (int)(n / 25);
+			in.a = ext[(n / 5) % 5];
+			in.b = ext[n % 5];
+		} else
+			idle(in);
+	}
+
+	void	idle(SIMDIN &in) {
+		in.mode = (int)urand<MBITS>();
+		in.a = urand<N>();
+		in.b = urand<N>();
+	}
+
+	template<class V> void	apply(V *core, const SIMDIN &in) {
+		core->i_mode = in.mode;
+		core->i_a = in.a;
+		core->i_b = in.b;
+	}
+};
+
+struct	SIMDCHECK {
+	template<class C> bool	check(typename C::V *core, const SIMDIN *in) {
+		unsigned long	p;
+
+		if (!in)
+			return true;
+
+		p = lanes(in->mode, in->a, in->b);
+		if ((unsigned long)core->o_p != p) {
+			printf("WRONG PRODUCT: MODE %d, %lx * %lx = %lx, not %lx\n",
+				in->mode, in->a, in->b,
+				(unsigned long)core->o_p, p);
+			return false;
+		}
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	SIMDSTIM	stim;
+	SIMDCHECK	chk;
+
+	runbench<SCORE>(stim, chk, total);
+
+	printf("All %ld%s products of %d bits, in lanes of %d down to %d bits, pass\n",
+		total, (exhaustive) ? "" : " extreme and random", N, N,
+		SDESC(_LANE));
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
@@ -42,6 +42,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
 
 #include "verilated.h"
 #include "verilated_vcd_c.h"
@@ -49,6 +51,8 @@
 #include "Vslowmpy.h"
 
 const	bool	trace = false;
+// Skip the extra eval() on every clock (--fast, or -f)
+bool	fast = false;
 const	int	NA=12, NB = NA;
 const	bool	OPT_SIGNED = true;
 
@@ -112,6 +116,16 @@ public:
 	void	tick(void) {
 		m_tickcount++;
 
+		if ((fast)&&(!m_strace)) {
+			// One eval() to settle the inputs with the clock low,
+			// and one for the rising edge
+			m_slow->i_clk = 0;
+			m_slow->eval();
+			m_slow->i_clk = 1;
+			m_slow->eval();
+			return;
+		}
+
 		m_slow->i_clk = 0;
 		m_slow->eval();
 		if (m_strace) m_strace->dump((uint64_t)(10*m_tickcount-2));
@@ -204,6 +218,20 @@ public:
 int	main(int argc, char **argv, char **envp) {
 	Verilated::commandArgs(argc, argv);
 	SLOWMPYTB		*tb = new SLOWMPYTB;
+	int	c;
+	static const struct option	long_options[] = {
+		{ "fast",	no_argument,	   NULL, 'f' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	while((c = getopt_long(argc, argv, "f", long_options, NULL)) != -1) {
+		switch(c) {
+		case 'f':	fast = true; break;
+		default:
+			fprintf(stderr, "USAGE: slowmpy_tb [--fast]\n");
+			exit(EXIT_FAILURE);
+		}
+	}
 
 	if (trace)
 		tb->opentrace("slowtrace.vcd");
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	sqr_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	An exhaustive test bench for the squaring cores written by
+//		"bldmpy --square <bits>".  Every i_a is squared by both
+//	usqr_N and sgnsqr_N, with i_ce dropped about a quarter of the time to
+//	check that o_p and o_aux hold, and every o_p is checked against the
+//	square found the simple way.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(USQR.h)
+#include PMSTR(SSQR.h)
+#include PMSTR(USQRH.h)
+#include PMSTR(SSQRH.h)
+
+#define	UDESC(X)	MPYCAT(USQR_, SQRSZ, X)
+#define	SDESC(X)	MPYCAT(SGNSQR_, SQRSZ, X)
+
+static const int	N = UDESC(_N), NP = UDESC(_NP);
+
+static_assert(NP < 64, "The squares must fit in a long");
+static_assert(SDESC(_N) == N, "The signed and unsigned cores don't match");
+
+MPYTBCORE(UCORE, USQR, UDESC, false, "U")
+MPYTBCORE(SCORE, SSQR, SDESC, true, "SGN")
+
+// The operand given on one clock
+struct	SQRIN {
+	unsigned long	a;
+	int		aux;
+};
+
+// Every operand in turn
+struct	SQRSTIM {
+	typedef	SQRIN	IN;
+
+	void	given(const long n, SQRIN &in) {
+		in.a = ubits<N>(n);
+	}
+
+	void	idle(SQRIN &in) {
+		in.a = ubits<N>(rand());
+	}
+
+	template<class V> void	apply(V *core, const SQRIN &in) {
+		core->i_a = in.a;
+	}
+};
+
+struct	SQRCHECK {
+	template<class C> bool	check(typename C::V *core, const SQRIN *in) {
+		unsigned long	p;
+
+		if (!in)
+			return true;
+
+		if (C::SGN)
+			p = ubits<NP>(sbits<N>(in->a) * sbits<N>(in->a));
+		else
+			p = ubits<NP>(in->a * in->a);
+
+		if ((unsigned long)core->o_p != p) {
+			printf("WRONG %s-SQUARE: %lx^2 = %lx, not %lx\n",
+				C::NAME, in->a, (unsigned long)core->o_p, p);
+			return false;
+		}
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	const long	total = 1l << N;
+	SQRSTIM		stim;
+	SQRCHECK	chk;
+
+	runbench<UCORE>(stim, chk, total);
+	runbench<SCORE>(stim, chk, total);
+
+	printf("All %ld squares of %d bits, from %d rows, pass\n", total, N,
+		UDESC(_ROWS));
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	trunc_tb.cpp
+//
+// Project:	A multiply core generator
+//
+// Purpose:	An exhaustive test bench for the truncated multiply cores
+//		written by "bldmpy --out-bits <bits>".  Every i_a is tried
+//	against every i_b, in both umpyhi_NxM and sgnmpyhi_NxM, with i_ce
+//	dropped about a quarter of the time to check that o_p holds.  Each
+//	o_p, shifted back up into place, is checked against the exact product,
+//	and must lie within the error bounds given in the core's description.
+//	The worst errors seen either way are reported at the end.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2015-2020, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory.  Run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "verilated.h"
+
+#define	MPYHELPERS_ONLY
+#include "mpycores.h"
+
+#define	PMSTR_(A)	#A
+#define	PMSTR(A)	PMSTR_(A)
+#include PMSTR(UHI.h)
+#include PMSTR(SHI.h)
+#include PMSTR(UHIH.h)
+#include PMSTR(SHIH.h)
+
+#define	UDESC(X)	MPYCAT(UMPYHI_, MPYSZ, X)
+#define	SDESC(X)	MPYCAT(SGNMPYHI_, MPYSZ, X)
+
+static const int	NA = UDESC(_NA), NB = UDESC(_NB),
+			NP = UDESC(_NP), NOUT = UDESC(_NOUT);
+
+static_assert(NP < 64, "The products must fit in a long");
+static_assert((SDESC(_NA) == NA)&&(SDESC(_NB) == NB)
+		&&(SDESC(_NOUT) == NOUT),
+	"The signed and unsigned cores don't match");
+
+MPYTBCORE(UCORE, UHI, UDESC, false, "U")
+MPYTBCORE(SCORE, SHI, SDESC, true, "SGN")
+
+// The operands given on one clock
+struct	TRUNCIN {
+	unsigned long	a, b;
+	int		aux;
+};
+
+// Every pair of operands in turn
+struct	TRUNCSTIM {
+	typedef	TRUNCIN	IN;
+
+	void	given(const long n, TRUNCIN &in) {
+		in.a = ubits<NA>(n >> NB);
+		in.b = ubits<NB>(n);
+	}
+
+	void	idle(TRUNCIN &in) {
+		in.a = ubits<NA>(rand());
+		in.b = ubits<NB>(rand());
+	}
+
+	template<class V> void	apply(V *core, const TRUNCIN &in) {
+		core->i_a = in.a;
+		core->i_b = in.b;
+	}
+};
+
+//
+// TRUNCCHECK
+//
+// Checks each product is within the error bounds its core's description
+// gives, keeping the worst errors seen from each core so far
+//
+struct	TRUNCCHECK {
+	long	m_elo[2], m_ehi[2];
+
+	TRUNCCHECK(void) {
+		m_elo[0] = m_elo[1] = m_ehi[0] = m_ehi[1] = 0;
+	}
+
+	template<class C> bool	check(typename C::V *core, const TRUNCIN *in) {
+		const long	elo = (C::SGN) ? SDESC(_ERR_LO) : UDESC(_ERR_LO),
+				ehi = (C::SGN) ? SDESC(_ERR_HI) : UDESC(_ERR_HI);
+		long	p, err;
+
+		if (!in)
+			return true;
+
+		if (C::SGN)
+			p = sbits<NA>(in->a) * sbits<NB>(in->b);
+		else
+			p = in->a * in->b;
+		err = sbits<NP>(((unsigned long)core->o_p << (NP-NOUT)) - p);
+
+		if ((err < elo)||(err > ehi)) {
+			printf("WRONG %s-PRODUCT: %lx * %lx = %lx, off by %ld, outside of [%ld, %ld]\n",
+				C::NAME, in->a, in->b,
+				(unsigned long)core->o_p, err, elo, ehi);
+			return false;
+		}
+		if (err < m_elo[C::SGN])
+			m_elo[C::SGN] = err;
+		if (err > m_ehi[C::SGN])
+			m_ehi[C::SGN] = err;
+		return true;
+	}
+};
+
+int	main(int argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	const long	total = 1l << (NA+NB);
+	TRUNCSTIM	stim;
+	TRUNCCHECK	chk;
+
+	runbench<UCORE>(stim, chk, total);
+	runbench<SCORE>(stim, chk, total);
+
+	printf("All %ld products within bounds, the top %d of %d bits\n",
+		total, NOUT, NP);
+	printf("Unsigned errors: [%ld, %ld] of [%ld, %ld]\n", chk.m_elo[0],
+		chk.m_ehi[0], (long)UDESC(_ERR_LO), (long)UDESC(_ERR_HI));
+	printf("Signed errors:   [%ld, %ld] of [%ld, %ld]\n", chk.m_elo[1],
+		chk.m_ehi[1], (long)SDESC(_ERR_LO), (long)SDESC(_ERR_HI));
+	printf("SUCCESS!\n");
+	exit(EXIT_SUCCESS);
+}
@@ -92,15 +92,51 @@ const char	cpyleft[] =
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <string.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <assert.h>
+#include <ctype.h>
 
 const char	prjname[] = "A multiply core generator";
 const char	creator[] =	"// Creator:	Dan Gisselquist, Ph.D.\n"
 				"//		Gisselquist Technology, LLC\n";
 
 bool	verbose_flag = true;
+// Build the signed core from radix-4 Booth rows, rather than around umpy
+bool	booth_flag = false;
+// Build the signed core from Baugh-Wooley rows, within umpy's own tableau
+bool	bw_flag = false;
+// Compressor layers between pipeline registers, or zero for an adder tree
+int	csa_layers = 0;
+// Clocks from i_a and i_b to o_p, or -1 to register every stage
+int	latency_budget = -1;
+// Build the unsigned core from umpy_TxT sub-cores this wide, or zero not to
+int	tile_size = 0;
+// Combine the sub-cores by Karatsuba-Ofman recursion, rather than one apiece
+bool	karatsuba_flag = false;
+// The shape of the hard (DSP) multipliers to build the unsigned core from,
+// or zero not to use any
+int	dsp_na = 0, dsp_nb = 0;
+// The width of the accumulator of the MAC cores, or zero not to build any
+int	mac_width = 0;
+// The bits of the product kept by the truncated cores, or zero not to build
+// any
+int	out_bits = 0;
+// Round the truncated cores' products to the nearest, rather than down
+bool	round_flag = false;
+// Make up for the columns the truncated cores drop with the bits of the
+// highest of them, rather than with a constant alone
+bool	varcomp_flag = false;
+// Also build a complex multiply, from three of the signed cores
+bool	cmplx_flag = false;
+// The narrowest lane of the packed SIMD core, or zero not to build one
+int	simd_width = 0;
+// The number of products the dot product cores add together, or zero not to
+// build any
+int	dot_count = 0;
 
 int	lg(int v) {
 	int	m=1, r=0;
@@ -125,11 +161,383 @@ int	post_stages(int npreouts) {
 	return lg(npreouts);
 }
 
+// Layers of 4:2 compressors (or 3:2's, for a group of three rows) needed to
+// bring nrows rows down to two
+int	csalayers(int nrows) {
+	int	nlayers = 0;
+
+	while(nrows > 2) {
+		nrows = 2*(nrows/4) + (((nrows%4) == 3) ? 2 : (nrows%4));
+		nlayers++;
+	}
+
+	return nlayers;
+}
+
+// Clocks from nrows registered rows to their sum, using compressors: one for
+// every csa_layers layers, and one more for the final adder
+int	csastages(int nrows) {
+	if (nrows < 2)
+		return 0;
+	return (csalayers(nrows) + csa_layers-1) / csa_layers + 1;
+}
+
+// Stages buildreduce() takes to add nwide rows of more than one bit, and
+// nbits rows of a single bit, together.  The single bits skip any
+// compressors, but always need an adder.
+int	reducestages(int nwide, int nbits) {
+	int	clocks = 0;
+
+	if ((csa_layers > 0)&&(nwide > 2)) {
+		clocks = (csalayers(nwide) + csa_layers-1) / csa_layers;
+		nwide = 2;
+	}
+	if (nwide > 1)
+		return clocks + lg(nwide);
+	return clocks + ((nbits > 0) ? 1:0);
+}
+
+// Is the core too big for a single tile?
+bool	tiled(int na, int nb) {
+	return (tile_size > 0)&&((na > tile_size)||(nb > tile_size));
+}
+
+// Tiles needed to cover n bits
+int	ntiles(int n) {
+	return (n + tile_size-1) / tile_size;
+}
+
+// Karatsuba splits both operands, zero extended to the same size, in half,
+// and then in half again until each half fits a tile
+int	karatsubasize(int na, int nb) {
+	int	n = tile_size;
+
+	while((n < na)||(n < nb))
+		n <<= 1;
+	return n;
+}
+
+// A schoolbook tiled core has two rows of tile products for every tile of
+// the operand with the fewest: one for the even tiles of the other operand,
+// and one for the odd ones
+int	tilerows(int na, int nb) {
+	const int	tx = std::min(ntiles(na), ntiles(nb)),
+			ty = std::max(ntiles(na), ntiles(nb));
+
+	return tx * ((ty > 1) ? 2:1);
+}
+
+// The sizes of the sub-cores a tiled core needs, largest first
+std::vector<int>	subcores(int na, int nb) {
+	std::vector<int>	r;
+
+	if (!tiled(na, nb))
+		return r;
+	if (!karatsuba_flag) {
+		r.push_back(tile_size);
+		return r;
+	}
+	for(int n=karatsubasize(na, nb)/2; n >= tile_size; n /= 2)
+		r.push_back(n);
+	return r;
+}
+
+//
+// DSPTILES
+//
+// How the hard multipliers are laid across the product: ka of them along
+// i_a, each taking wa bits of it, by kb along i_b, each taking wb bits.
+// Whatever's left over, at the top of either operand, is left to LUTs.
+//
+typedef	struct {
+	int	wa, wb, ka, kb;
+} DSPTILES;
+
+// Lays the hard multipliers out whichever way around covers the most of the
+// product.  An operand narrower than the multiplier uses only part of it.
+DSPTILES	dsptiles(int na, int nb) {
+	DSPTILES	t[2];
+
+	for(int k=0; k<2; k++) {
+		const int	da = (k == 0) ? dsp_na : dsp_nb,
+				db = (k == 0) ? dsp_nb : dsp_na;
+
+		t[k].wa = (na < da) ? na : da;
+		t[k].wb = (nb < db) ? nb : db;
+		t[k].ka = na / t[k].wa;
+		t[k].kb = nb / t[k].wb;
+	}
+
+	if (t[1].ka*t[1].wa * t[1].kb*t[1].wb > t[0].ka*t[0].wa * t[0].kb*t[0].wb)
+		return t[1];
+	return t[0];
+}
+
+// Rows of LUT partial products needed for an na by nb strip, one for every
+// premul bits of its narrower side
+int	lutrows(int premul, int na, int nb) {
+	if ((na == 0)||(nb == 0))
+		return 0;
+	return npremul(premul, na, nb);
+}
+
+// One row for every hard multiplier, and the LUT rows of both strips: the
+// top of i_a by all of i_b, and the rest of i_a by the top of i_b
+int	dsprows(int premul, int na, int nb) {
+	const DSPTILES	t = dsptiles(na, nb);
+
+	return t.ka * t.kb + lutrows(premul, na - t.ka*t.wa, nb)
+		+ lutrows(premul, t.ka*t.wa, nb - t.kb*t.wb);
+}
+
 int	stages(int premul, int na, int nb) {
 	int	ps = npremul(premul, na, nb);
+
+	if (dsp_na > 0)
+		// Every row, hard or LUT, is registered before being added
+		return 1 + reducestages(dsprows(premul, na, nb), 0);
+
+	if ((tiled(na, nb))&&(karatsuba_flag)) {
+		// A register to split the operands, the half-sized cores, and
+		// then five rows to add: one of them a single bit
+		const int	h = karatsubasize(na, nb)/2;
+
+		return 1 + stages(premul, h, h) + reducestages(4, 1);
+	} else if (tiled(na, nb))
+		return stages(premul, tile_size, tile_size)
+			+ reducestages(tilerows(na, nb), 0);
+
+	if (csa_layers > 0)
+		return 1+csastages(ps);
 	return 1+post_stages(ps);
 }
 
+// Stages of a MAC core: the tableau, the adders or compressors that leave
+// two of its rows, and the one stage adding both to the accumulator
+int	macstages(int premul, int na, int nb) {
+	return 1 + std::max(1, reducestages(npremul(premul, na, nb), 0));
+}
+
+//
+// TRUNC
+//
+// What a truncated core (--out-bits) keeps of its tableau: every column from
+// lo up.  comp is added to the rows, along with any Baugh-Wooley constant, to
+// make up for the columns below, so that o_p, shifted back up into place,
+// less the exact product lies within [elo, ehi].
+//
+typedef	struct {
+	int	lo;
+	long	comp, elo, ehi;
+} TRUNC;
+
+// Partial products in column c of an ns by nl tableau
+int	colbits(int ns, int nl, int c) {
+	return std::min(std::min(c+1, ns), std::min(nl, ns+nl-1-c));
+}
+
+// The truncated core keeping the top nout bits of an ns by nl product.
+// Columns are dropped for as long as the most they could sum to, together
+// with the rounding of comp to a multiple of the lowest column kept, stays
+// within one bit of o_p.  comp then sits halfway between the least and most
+// the dropped columns could have been (plus half a bit of o_p to round to the
+// nearest), less whatever of the Baugh-Wooley constant lies below lo.  With
+// varcomp_flag, the bits of the highest dropped column are added into the
+// lowest one kept, at twice their weight, so half of that column is then too
+// much rather than too little.
+TRUNC	truncation(int ns, int nl, int nout, bool sgn) {
+	const int	t = ns+nl-nout;
+	long		dsum = 0, dmin = 0, dmax, mid, r, m, bw;
+	TRUNC		tr;
+
+	tr.lo = 0;
+	for(int c=0; c<t; c++) {
+		const long	n = colbits(ns, nl, c);
+
+		if (n > (((1l<<t) - dsum - (2l<<c)) >> c))
+			break;
+		dsum += n << c;
+		tr.lo = c+1;
+	}
+
+	if ((varcomp_flag)&&(tr.lo > 0))
+		dmin = -((long)colbits(ns, nl, tr.lo-1) << (tr.lo-1));
+	dmax = dsum + dmin;
+
+	mid = (dmin + dmax + ((round_flag) ? (1l<<t)-1 : 0)) >> 1;
+	bw = (sgn) ? (1l<<(nl-1)) + (1l<<(ns-1)) : 0;
+	m = 1l << tr.lo;
+	r = (mid + bw) & (m-1);
+	tr.comp = mid - r + ((2*r > m) ? m : 0);
+	tr.elo = tr.comp - dmax - ((1l<<t)-1);
+	tr.ehi = tr.comp - dmin;
+	return tr;
+}
+
+// Rows of the tableau holding anything at or above column lo, or (with var)
+// at lo-1
+int	truncrows(int premul, int ns, int nl, int lo, bool var) {
+	int	nrows = 0;
+
+	for(int lsb=0; lsb<ns; lsb+=premul)
+		if (lsb + std::min(premul, ns-lsb) + nl-2 >= lo - ((var)?1:0))
+			nrows++;
+	return nrows;
+}
+
+// Stages of a truncated core: the rows it keeps of the tableau, and then the
+// adders (or compressors) between them
+int	truncstages(int premul, int na, int nb, int nout) {
+	const int	ns = std::min(na, nb), nl = std::max(na, nb);
+	const TRUNC	tr = truncation(ns, nl, nout, false);
+
+	return 1 + reducestages(truncrows(premul, ns, nl, tr.lo,
+			varcomp_flag), 0);
+}
+
+// The folded tableau of an n-bit square (--square).  Every product of two
+// different bits, x_i x_j, appears twice in x*x, and so only once here, at
+// twice the weight, in column i+j+1, while x_i x_i is just x_i, in column 2i.
+// The columns are then packed down, so that level r holds the r-th partial
+// product of every column with more than r of them, or "" in columns with
+// fewer.  With sgn, the products of the sign bit with any other bit are
+// inverted, as Baugh and Wooley would.
+std::vector<std::vector<std::string> >	sqrlevels(int n, bool sgn) {
+	std::vector<std::vector<std::string> >	levels;
+	char	str[64];
+
+	for(int c=0; c<2*n; c++) {
+		std::vector<std::string>	terms;
+
+		if ((c % 2 == 0)&&(c/2 < n)) {
+			sprintf(str, "i_a[%d]", c/2);
+			terms.push_back(str);
+		}
+		for(int i=std::max(0, c-n); 2*i < c-1; i++) {
+			sprintf(str, "%s(i_a[%d] & i_a[%d])",
+				((sgn)&&(c-1-i == n-1)) ? "~":"", i, c-1-i);
+			terms.push_back(str);
+		}
+
+		for(unsigned r=0; r<terms.size(); r++) {
+			if (r >= levels.size())
+				levels.push_back(std::vector<std::string>(2*n));
+			levels[r][c] = terms[r];
+		}
+	}
+
+	return levels;
+}
+
+// Rows of a square's tableau: premul levels apiece, but for a last level left
+// on its own.  That one holds at most two bits, in the middle columns, which
+// are left as rows of a single bit each.
+int	sqrrows(int premul, int n, int &nbits) {
+	const std::vector<std::vector<std::string> >	levels
+				= sqrlevels(n, false);
+	const int	nlevels = levels.size();
+
+	nbits = 0;
+	if ((nlevels > 1)&&(nlevels % premul == 1)) {
+		for(int c=0; c<2*n; c++)
+			if (levels[nlevels-1][c].size() > 0)
+				nbits++;
+		return nlevels / premul;
+	}
+	return (nlevels + premul-1) / premul;
+}
+
+// Stages of a squaring core: the rows of its folded tableau, and then the
+// adders (or compressors) between them
+int	sqrstages(int premul, int n) {
+	int	nbits, nwide = sqrrows(premul, n, nbits);
+
+	return 1 + reducestages(nwide, nbits);
+}
+
+// Lane widths a packed SIMD core (--simd) can be set to: all n bits, half of
+// them, and so on down to lane bits
+int	simdmodes(int n, int lane) {
+	return lg(n / lane) + 1;
+}
+
+// Stages of a packed SIMD core: its gated tableau has just as many rows as
+// the unsigned core's, added together the same way
+int	simdstages(int premul, int n) {
+	return 1 + reducestages(npremul(premul, n, n), 0);
+}
+
+// Bits in the sum of n products of na by nb bits, signed or not
+int	dotbits(int n, int na, int nb) {
+	return na + nb + lg(n);
+}
+
+// Stages of a dot product core (--dot): the rows of every product's tableau,
+// all added together in the one tree
+int	dotstages(int premul, int n, int na, int nb) {
+	return 1 + reducestages(n * npremul(premul, na, nb), 0);
+}
+
+// One radix-4 Booth digit, and so one row, for every two bits of the
+// smaller (signed) operand
+int	boothrows(int na, int nb) {
+	int	ns = (na < nb) ? na : nb;
+
+	return (ns+1)/2;
+}
+
+// The Booth rows are registered, and then added pairwise (or compressed).
+// The last row's negation bit always takes a round of its own to add in, even
+// if there's only the one row.
+int	boothstages(int na, int nb) {
+	int	nrows = boothrows(na, nb);
+
+	if (csa_layers > 0)
+		return 1 + ((nrows > 1) ? csastages(nrows) : 1);
+	return 1 + ((nrows > 1) ? lg(nrows) : 1);
+}
+
+// Clocks (with i_ce) from i_a and i_b to o_p.  The signed core adds one
+// clock on either side of the unsigned one, unless it's a Booth or a
+// Baugh-Wooley core.  A latency budget (-l) may take any of these clocks away.
+int	latency(int premul, int na, int nb, bool sgn) {
+	int	clocks;
+
+	if ((sgn)&&(booth_flag))
+		clocks = boothstages(na, nb);
+	else
+		clocks = stages(premul, na, nb) + (((sgn)&&(!bw_flag)) ? 2:0);
+	if ((latency_budget >= 0)&&(latency_budget < clocks))
+		return latency_budget;
+	return clocks;
+}
+
+// Clocks of a complex core (--complex): one for the pre-adders, the slower
+// of its two sizes of real multiply, and one for the post-adders
+int	cmplxstages(int premul, int na, int nb) {
+	return 2 + std::max(latency(premul, na+1, nb, true),
+			latency(premul, nb+1, na, true));
+}
+
+//
+// PIPELINE
+//
+// The number of stages of logic in a core, and how many of them end in a
+// register.  Every stage ends in one unless there's a latency budget.
+//
+typedef	struct {
+	int	nstages, delay;
+} PIPELINE;
+
+// Does the given stage end in a register?  The registers are spread as
+// evenly as they can be across the stages, and the last stage always gets
+// one if there are any at all.
+bool	regstage(const PIPELINE &pipe, const int stage) {
+	assert((stage >= 0)&&(stage < pipe.nstages));
+	return ((stage+1)*pipe.delay / pipe.nstages)
+			> (stage*pipe.delay / pipe.nstages);
+}
+
 void	buildbimpy(FILE *fp, char *name, bool async_reset) {
 	fprintf(fp,
 "////////////////////////////////////////////////////////////////////////////////\n"
@@ -231,6 +639,7 @@ void	buildsubmpy(FILE *fp, char *name, int nmul, bool async_reset) {
 "// Purpose:	An %dxN-bit unsigned  multiply built straight from logic and\n"
 "//		one addition.  This can be used to turn an NxN bit multiply\n"
 "//	into a sum of (N/%d)*N terms.\n"
+"//\n"
 "%s"
 "//\n"
 "%s",
@@ -246,56 +655,43 @@ void	buildsubmpy(FILE *fp, char *name, int nmul, bool async_reset) {
 		nmul, (async_reset)?"i_areset_n":"i_reset");
 		
 	fprintf(fp,
-	"\tinput\t\t[(LUTB-1):0]\ti_a;\n"
-	"\tinput\t\t[(BW-1):0]\ti_b;\n"
+	"\tinput\twire\t[(LUTB-1):0]\ti_a;\n"
+	"\tinput\twire\t[(BW-1):0]\ti_b;\n"
 	"\toutput\treg\t[(BW+LUTB-1):0]\to_r;\n"
-"\n"
-	"\twire\t[(GENM+LUTB-1):0]\tw_r;\n"
 "\n");
 
+	// Each LUTB bit slice of i_b, times i_a, gives LUTB bits of genm_r
+	// and LUTB bits of genm_c (the carry into the next slice up).  Every
+	// one of those bits depends upon i_a and the one slice alone, so it
+	// maps to the same LUTs a 2^(2*LUTB) entry table would, but costs
+	// Verilator only LUTB-1 additions.
 	fprintf(fp,
 	"\tlocalparam\tGENM = (((BW+LUTB-1)/LUTB)*LUTB);\n"
-	"\twire\t[GENM-1:0]\tgenm_r, genm_c;\n\n");
+	"\twire\t[GENM-1:0]\tgenm_r, genm_c;\n"
+	"\twire\t[(GENM+LUTB-1):0]\tw_r;\n\n");
 
 	fprintf(fp,
 	"\tgenvar k;\n"
 	"\tgenerate\n"
-	"\tbegin\n"
 	"\tfor(k=0; k < BW; k=k+LUTB)\n"
-	"\tbegin\n"
+	"\tbegin : LUTSLICE\n"
 	"\t\twire\t[LUTB-1:0]\tb_slice;\n"
-	"\t\tif (k+LUTB < BW)\n"
+	"\t\tif (k+LUTB <= BW)\n"
 	"\t\t\tassign b_slice = i_b[k +: LUTB];\n"
 	"\t\telse\n"
 	"\t\t\tassign b_slice = { {(k+LUTB-BW){1\'b0}}, i_b[BW-1:k] };\n"
 	"\n"
-	"\t\talways @(*)\n"
-	"\t\t\tcase({ i_a, b_slice })\n");
-	for(int b=0; b<(1<<(2*nmul)); b++) {
-		unsigned	msk;
-
-		msk = (1<<nmul)-1;
-		fprintf(fp, "\t\t\t%d\'h%0*x: ", 2*nmul, (2*nmul+3)/4, b);
-		fprintf(fp, "genm_r[k +: LUTB] = %d\'h%0*x;\n",
-			nmul, (nmul+3)/4,
-			(((b>>(nmul))&msk) * (b & msk))&msk);
-	} fprintf(fp,"\t\t\tendcase\n\n");
-
-	fprintf(fp,
-	"\n"
-	"\t\talways @(*)\n"
-	"\t\t\tcase({ i_a, b_slice })\n");
-	for(int b=0; b<(1<<(2*nmul)); b++) {
-		unsigned	msk;
+	"\t\tassign\t{ genm_c[k +: LUTB], genm_r[k +: LUTB] }\n"
+	"\t\t\t= ");
+	for(int b=0; b<nmul; b++) {
+		fprintf(fp, "%s{ %d\'b0, ((i_a[%d]) ? b_slice : %d\'b0)",
+			(b > 0) ? "\n\t\t\t+ " : "", nmul-b, b, nmul);
+		if (b > 0)
+			fprintf(fp, ", %d\'b0", b);
+		fprintf(fp, " }");
+	} fprintf(fp, ";\n");
 
-		msk = (1<<nmul)-1;
-		fprintf(fp, "\t\t\t%d\'h%0*x: ", 2*nmul, (2*nmul+3)/4, b);
-		fprintf(fp, "genm_c[k +: LUTB] = %d\'h%0*x;\n",
-			nmul, (nmul+3)/4,
-			((((b>>(nmul))&msk) * (b & msk))>>(nmul))&msk);
-	} fprintf(fp,"\t\t\tendcase\n\n");
-
-	fprintf(fp,"\tend end endgenerate\n\n");
+	fprintf(fp,"\tend endgenerate\n\n");
 
 	fprintf(fp,
 		"\tassign\tw_r = { %d\'b0, genm_r } + { genm_c, %d\'b0 };\n",
@@ -320,16 +716,172 @@ void	buildsubmpy(FILE *fp, char *name, int nmul, bool async_reset) {
 		"\t// Make Verilator happen\n"
 		"\t// verilator lint_off UNUSED\n"
 		"\tgenerate if (GENM > BW)\n"
-		"\tbegin\n"
+		"\tbegin : UNUSED_BITS\n"
 		"\t\twire\t[GENM-BW-1:0]	unused;\n"
 		"\t\tassign unused = { w_r[GENM+LUTB-1:BW+LUTB] };\n"
 		"\tend endgenerate\n"
 		"\t// verilator lint_on  UNUSED\n");
 
+	// Unlike bimpy's, these properties check every product
+	fprintf(fp, "\n"
+"`ifdef	FORMAL\n"
+"\treg	f_past_valid;\n"
+"\n"
+"\tinitial	f_past_valid = 1'b0;\n"
+"\talways @(posedge i_clk)\n"
+"\tf_past_valid <= 1'b1;\n"
+"\n"
+"`define	ASSERT	assert\n"
+"\n");
 	fprintf(fp,
+"\talways @(posedge i_clk)\n"
+"\tif ((f_past_valid)&&($past(%s)))\n"
+"\t\t`ASSERT(o_r == 0);\n"
+"\telse if ((f_past_valid)&&($past(i_ce)))\n"
+"\t\t`ASSERT(o_r == $past(i_a) * $past(i_b));\n"
+"\telse if (f_past_valid)\n"
+"\t\t`ASSERT($stable(o_r));\n",
+		(async_reset)?"!i_areset_n":"i_reset");
+	fprintf(fp,
+"`endif\n"
 "endmodule\n");
 }
 
+//
+// buildformal
+//
+// The formal properties shared by every core built around a pipeline of
+// stages, with A_0, A_1, and so on carrying i_aux along beside them.  Only
+// the stages that end in a register delay o_p and o_aux, so only those are
+// checked as part of the pipeline.  sgn checks o_p against a signed
+// product, rather than an unsigned one.
+//
+void	buildformal(FILE *fp, const PIPELINE &pipe, const bool aux,
+		const bool async_reset, const bool sgn) {
+	const int	clock = pipe.delay-1;
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+
+	fprintf(fp, "\treg\tf_past_valid;\n"
+	"\tinitial\tf_past_valid = 0;\n"
+	"\talways @(posedge i_clk)\n"
+	"\t\tf_past_valid <= 1\'b1;\n\n");
+
+	if ((aux)&&(pipe.delay == 0)) {
+		fprintf(fp, "\talways @(*)\n"
+			"\t\tassert(o_aux == i_aux);\n\n");
+	} else if (aux) {
+		fprintf(fp,
+		"\twire	[%d+1:0]\tf_auxpipe;\n"
+		"\tassign\tf_auxpipe\t= { ", clock);
+		for(int k=pipe.nstages-1; k>=0; k--)
+			if (regstage(pipe, k))
+				fprintf(fp, "A_%d,", k);
+		fprintf(fp, " i_aux };\n\n");
+
+		fprintf(fp, "\tinitial\tassume(!i_aux);\n");
+		fprintf(fp, "\talways @(posedge i_clk)\n"
+			"\tif ((%s)||((f_past_valid)&&($past(%s))))\n"
+			"\t\tassume(!i_aux);\n\n",
+			(async_reset)? "!i_areset_n":"i_reset",
+			(async_reset)? "!i_areset_n":"i_reset");
+
+		fprintf(fp, "\tinitial\tassert(f_auxpipe == 0);\n");
+		fprintf(fp, "\talways @(posedge i_clk)\n");
+		fprintf(fp, "\tif ((f_past_valid)&&($past(%s)))\n",
+			(async_reset)?"!i_areset_n":"i_reset");
+		fprintf(fp, "\t\tassert(f_auxpipe == 0);\n");
+		fprintf(fp, "\talways @(posedge i_clk)\n");
+		fprintf(fp, "\tif ((f_past_valid)&&(!$past(%s))&&($past(i_ce)))\n",
+			(async_reset)?"!i_areset_n":"i_reset");
+		fprintf(fp, "\t\tassert(f_auxpipe[%d+1:1] == $past(f_auxpipe[%d:0]));\n\n", clock,clock);
+		fprintf(fp, "\talways @(posedge i_clk)\n");
+		fprintf(fp, "\tif ((f_past_valid)&&(!$past(%s))&&(!$past(i_ce)))\n",
+			(async_reset)?"!i_areset_n":"i_reset");
+		fprintf(fp, "\t\tassert(f_auxpipe[%d+1:1] == $past(f_auxpipe[%d+1:1]));\n\n", clock,clock);
+	}
+
+	if (pipe.delay == 0) {
+		// With no registers at all, o_p follows i_a and i_b directly
+		fprintf(fp, "\treg	[NA+NB-1:0]	f_result;\n");
+		if (!sgn)
+			fprintf(fp, "\tinteger\t\t\tik;\n");
+		fprintf(fp, "\n\talways @(*)\n");
+		if (sgn)
+			fprintf(fp, "\t\tf_result = i_a * i_b;\n\n");
+		else
+			fprintf(fp,
+			"\tbegin\n"
+				"\t\tf_result = 0;\n"
+				"\t\tfor(ik=0; ik<NS; ik=ik+1)\n"
+				"\t\t\tif(i_a[ik])\n"
+				"\t\t\t\tf_result = f_result + { {(NL-ik-1){1\'b0}},\n"
+				"\t\t\t\t\t\ti_b, { (ik){1\'b0} } };\n"
+			"\tend\n\n");
+		fprintf(fp, "\talways @(*)\n"
+			"\t\tassert(o_p == f_result);\n\n");
+		fprintf(fp, "`endif\n");
+		return;
+	}
+
+	fprintf(fp,
+	"\tlocalparam\tF_DELAY = %d;\n", clock);
+	if (sgn) {
+		// i_a and i_b are both signed, so the product is too
+		fprintf(fp,
+		"\treg	[NA+NB-1:0]	f_result;\n"
+		"\n\tinitial\tf_result = 0;\n"
+		"%s"
+			"\t\tf_result = 0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tf_result = i_a * i_b;\n"
+		"\n", always_reset.c_str());
+	} else
+	fprintf(fp,
+	"\treg	[NA+NB-1:0]	f_result;\n"
+	"\tinteger\t\t\tik;\n"
+	"\n\tinitial\tf_result = 0;\n"
+	"%s"
+		"\t\tf_result = 0;\n"
+		"\telse if (i_ce)\n"
+		"\tbegin\n"
+			"\t\tf_result = 0;\n"
+			"\t\tfor(ik=0; ik<NS; ik=ik+1)\n"
+			"\t\t\tif(i_a[ik])\n"
+			"\t\t\t\tf_result = f_result + { {(NL-ik-1){1\'b0}},\n"
+			"\t\t\t\t\t\ti_b, { (ik){1\'b0} } };\n"
+		"\tend\n"
+	"\n", always_reset.c_str());
+
+	if (pipe.delay == 1)
+		// f_result is already as late as o_p
+		fprintf(fp,
+		"\talways @(posedge i_clk)\n"
+		"\t\tassert(o_p == f_result);\n\n");
+	else
+	fprintf(fp,
+	"\treg\t[F_DELAY*(NA+NB)-1:0]	f_result_pipe;\n"
+	"\n\tinitial\tf_result_pipe = 0;\n%s"
+		"\t\tf_result_pipe <= 0;\n"
+		"\telse if (i_ce)\n"
+		"\t\tf_result_pipe <= { f_result, f_result_pipe[((F_DELAY)*(NA+NB)-1):(NA+NB)] };\n"
+	"\n"
+		"\talways @(posedge i_clk)\n"
+		"\t\tassert(o_p == f_result_pipe[(NA+NB-1):0]);\n\n",
+		always_reset.c_str());
+
+	fprintf(fp,
+	 	"\talways @(posedge i_clk)\n"
+	 	"\t\tassume((i_ce)\n"
+		"\t\t\t||((f_past_valid)&&($past(i_ce)))\n"
+		"\t\t\t// ||(($past(f_past_valid))&&($past(i_ce,2)))\n"
+		"\t\t\t);\n\n");
+	fprintf(fp, "`endif\n");
+}
+
 void	buildsmpy(FILE *fp, const char *name,
 	const int premul, const int na, const int nb,
 	const bool aux, const bool async_reset) {
@@ -338,6 +890,14 @@ void	buildsmpy(FILE *fp, const char *name,
 	nl = (na < nb) ? nb : na;
 
 	// int clock, nlits, nrows, nzros, row, maxbits = ns+nl;
+	// A latency budget may leave no room to register the negations on
+	// the way in and out of umpy.  The sign then needs delaying only as
+	// long as umpy (and any input register) takes.
+	const int	ulat = latency(premul, na, nb, false),
+			slat = latency(premul, na, nb, true),
+			nsgn = ulat + ((slat - ulat >= 2) ? 1:0);
+	const bool	inreg = (slat - ulat >= 2), outreg = (slat - ulat >= 1);
+	char		sgnbit[64];
 	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
 	if (async_reset)
 		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
@@ -367,11 +927,13 @@ void	buildsmpy(FILE *fp, const char *name,
 		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
 		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
 		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb,
-		stages(premul, na, nb)+1,
+		slat-1,
 		(async_reset)?"i_areset_n":"i_reset");
 	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
-	fprintf(fp, "\toutput\treg\tsigned\t[(NA+NB-1):0]\to_p;\n");
-	if (aux) fprintf(fp, "\toutput\treg\t\t\t\to_aux;\n");
+	fprintf(fp, "\toutput\t%s\tsigned\t[(NA+NB-1):0]\to_p;\n",
+		(outreg) ? "reg" : "wire");
+	if (aux) fprintf(fp, "\toutput\t%s\t\t\t\to_aux;\n",
+		(outreg) ? "reg" : "wire");
 
 	fprintf(fp, "\n");
 	fprintf(fp, "\tlocalparam NS = (NA < NB) ? NA : NB;\n");
@@ -392,44 +954,77 @@ void	buildsmpy(FILE *fp, const char *name,
 "\tend endgenerate\n\n");
 
 
-	fprintf(fp, "\treg\t\t[(NS-1):0]\tu_s;\n");
-	fprintf(fp, "\treg\t\t[(NL-1):0]\tu_l;\n");
-	fprintf(fp, "\treg\t\t[(DLY-1):0]\tu_sgn;\n");
-	if (aux)
-		fprintf(fp, "\treg\t\t\t\tu_aux;\n\n");
-	else
+	if (!inreg) {
+		fprintf(fp, "\twire\t\t[(NS-1):0]\tu_s;\n");
+		fprintf(fp, "\twire\t\t[(NL-1):0]\tu_l;\n");
+		if (aux)
+			fprintf(fp, "\twire\t\t\t\tu_aux;\n");
+		fprintf(fp, "\n"
+			"\tassign\tu_s = (i_s[NS-1])?(-i_s):i_s;\n"
+			"\tassign\tu_l = (i_l[NL-1])?(-i_l):i_l;\n");
+		if (aux)
+			fprintf(fp, "\tassign\tu_aux = i_aux;\n");
 		fprintf(fp, "\n");
+	} else {
+		fprintf(fp, "\treg\t\t[(NS-1):0]\tu_s;\n");
+		fprintf(fp, "\treg\t\t[(NL-1):0]\tu_l;\n");
+		fprintf(fp, "\treg\t\t[(DLY-1):0]\tu_sgn;\n");
+		if (aux)
+			fprintf(fp, "\treg\t\t\t\tu_aux;\n\n");
+		else
+			fprintf(fp, "\n");
 
-	if (aux) {
-		fprintf(fp, "\tinitial\tu_aux = 1\'b0;\n");
-		fprintf(fp, "%s", always_reset.c_str());
+		if (aux) {
+			fprintf(fp, "\tinitial\tu_aux = 1\'b0;\n");
+			fprintf(fp, "%s", always_reset.c_str());
+
+			fprintf(fp,
+			"\t\t\tu_aux <= 1'b0;\n"
+			"\t\telse if (i_ce)\n"
+			"\t\t\tu_aux <= i_aux;\n\n");
+		}
 
+		fprintf(fp, "\tinitial\tu_s = 0;\n");
+		fprintf(fp, "\tinitial\tu_l = 0;\n");
+		fprintf(fp, "%s", always_reset.c_str());
 		fprintf(fp,
-		"\t\t\tu_aux <= 1'b0;\n"
-		"\t\telse if (i_ce)\n"
-		"\t\t\tu_aux <= i_aux;\n\n");
+		"\tbegin\n"
+			"\t\tu_s <= 0;\n"
+			"\t\tu_l <= 0;\n"
+		"\tend else if (i_ce)\n"
+		"\tbegin\n"
+			"\t\tu_s <= (i_s[NS-1])?(-i_s):i_s;\n"
+			"\t\tu_l <= (i_l[NL-1])?(-i_l):i_l;\n"
+		"\tend\n"
+	"\n");
+		fprintf(fp, "\tinitial\tu_sgn = 0;\n");
+		fprintf(fp, "%s"
+			"\t\tu_sgn <= 0;\n"
+		"\telse if (i_ce)\n"
+			"\t\tu_sgn <= { u_sgn[(DLY-2):0], ((i_s[NS-1])^(i_l[NL-1])) };\n"
+	"\n",
+			always_reset.c_str());
 	}
 
-	fprintf(fp, "\tinitial\tu_s = 0;\n");
-	fprintf(fp, "\tinitial\tu_l = 0;\n");
-	fprintf(fp, "%s", always_reset.c_str());
-	fprintf(fp,
-	"\tbegin\n"
-		"\t\tu_s <= 0;\n"
-		"\t\tu_l <= 0;\n"
-	"\tend else if (i_ce)\n"
-	"\tbegin\n"
-		"\t\tu_s <= (i_s[NS-1])?(-i_s):i_s;\n"
-		"\t\tu_l <= (i_l[NL-1])?(-i_l):i_l;\n"
-	"\tend\n"
-"\n");
-	fprintf(fp, "\tinitial\tu_sgn = 0;\n");
-	fprintf(fp, "%s"
-		"\t\tu_sgn <= 0;\n"
-	"\telse if (i_ce)\n"
-		"\t\tu_sgn <= { u_sgn[(DLY-2):0], ((i_s[NS-1])^(i_l[NL-1])) };\n"
-"\n",
-		always_reset.c_str());
+	// The sign of the product, delayed to match u_r
+	if (inreg)
+		strcpy(sgnbit, "u_sgn[DLY-1]");
+	else if (nsgn == 0) {
+		strcpy(sgnbit, "u_sgn");
+		fprintf(fp, "\twire\t\t\t\tu_sgn;\n"
+			"\tassign\tu_sgn = (i_s[NS-1])^(i_l[NL-1]);\n\n");
+	} else {
+		sprintf(sgnbit, "u_sgn[%d]", nsgn-1);
+		fprintf(fp, "\treg\t\t[%d:0]\tu_sgn;\n\n"
+			"\tinitial\tu_sgn = 0;\n", nsgn-1);
+		fprintf(fp, "%s"
+			"\t\tu_sgn <= 0;\n"
+		"\telse if (i_ce)\n", always_reset.c_str());
+		if (nsgn == 1)
+			fprintf(fp, "\t\tu_sgn <= ((i_s[NS-1])^(i_l[NL-1]));\n\n");
+		else
+			fprintf(fp, "\t\tu_sgn <= { u_sgn[%d:0], ((i_s[NS-1])^(i_l[NL-1])) };\n\n", nsgn-2);
+	}
 
 	fprintf(fp,
 "\twire\t[(NA+NB-1):0]\tu_r;\n%s"
@@ -438,34 +1033,592 @@ void	buildsmpy(FILE *fp, const char *name,
 		ns, nl, (async_reset)?" i_areset_n":"i_reset",
 		(aux)?" u_aux,":"", (aux)?", w_aux":"");
 
+	if (!outreg) {
+		fprintf(fp, "\n\tassign\to_p = (%s)?(-u_r):u_r;\n", sgnbit);
+		if (aux)
+			fprintf(fp, "\tassign\to_aux = w_aux;\n");
+	} else {
 	fprintf(fp,
 "\n"
 "\tinitial\to_p = 0;\n"
 "%s"
 	"\t\to_p <= 0;\n"
 	"\telse if (i_ce)\n"
-		"\t\to_p <= (u_sgn[DLY-1])?(-u_r):u_r;\n"
-"\n", always_reset.c_str());
+		"\t\to_p <= (%s)?(-u_r):u_r;\n"
+"\n", always_reset.c_str(), sgnbit);
 
 	if (aux) fprintf(fp, "\n\tinitial\to_aux = 1\'b0;\n%s"
 			"\t\to_aux <= 1'b0;\n"
 		"\telse if (i_ce)\n"
 			"\t\to_aux <= w_aux;\n\n", always_reset.c_str());
+	}
 
 	fprintf(fp, "\nendmodule\n");
 }
 
-void	buildumpy(FILE *fp, char *name, int premul, const int na, const int nb, bool aux, bool async_reset) {
-	int	row, clock, nbits, nrows, nzros, maxbits = na+nb,
-		unused = 0, sz, lastsz;
-	char	ustr[1024];
-	ustr[0] = '\0';
-	int	ns, nl;
-	ns = (na < nb) ? na : nb;
-	nl = (na < nb) ? nb : na;
+//
+// PPROW
+//
+// One row of partial products on its way through buildtree(): the wire or
+// register (or single bit of one) holding it, and where it sits within the
+// product.
+//
+typedef	struct {
+	std::string	name;
+	int		lsb, width;
+} PPROW;
+
+//
+// alignrow
+//
+// Bits [lsb+width-1:lsb] of the product, as held by row, in an expression of
+// exactly width bits.  Anything the row holds outside of that range is left
+// out, and a row holding nothing within it is all zeros.
+//
+std::string	alignrow(const PPROW &row, const int lsb, const int width) {
+	int		lo = row.lsb, hi = row.lsb + row.width - 1,
+			below, above;
+	std::string	name = row.name;
+	char		str[64];
+
+	if (lo < lsb)
+		lo = lsb;
+	if (hi > lsb + width - 1)
+		hi = lsb + width - 1;
+	if (hi < lo) {
+		sprintf(str, "%d\'b0", width);
+		return str;
+	}
+	below = lo - lsb;
+	above = lsb + width - 1 - hi;
+
+	if (hi - lo + 1 < row.width) {
+		sprintf(str, "[%d:%d]", hi - row.lsb, lo - row.lsb);
+		name += str;
+	}
+
+	if ((above == 0)&&(below == 0))
+		return name;
+
+	std::string	r = "{ ";
+	if (above > 0) {
+		sprintf(str, "%d\'b0, ", above);
+		r += str;
+	}
+	r += name;
+	if (below > 0) {
+		sprintf(str, ", %d\'b0", below);
+		r += str;
+	}
+	return r + " }";
+}
+
+//
+// buildstage
+//
+// Writes the rows that end a stage, each set to its own expression: as
+// registers, cleared on reset and set on i_ce, if the stage ends in a
+// register, or as wires otherwise.  A_clock follows i_aux along with them.
+//
+void	buildstage(FILE *fp, const std::vector<PPROW> &rows,
+		const std::vector<std::string> &expr, const int clock,
+		const bool registered, const bool aux,
+		const std::string &always_reset) {
+	if (!registered) {
+		for(unsigned k=0; k<rows.size(); k++)
+			fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+				"\tassign\t%s = %s;\n",
+				rows[k].width-1, rows[k].name.c_str(),
+				rows[k].lsb+rows[k].width-1, rows[k].lsb,
+				rows[k].name.c_str(), expr[k].c_str());
+		if (aux)
+			fprintf(fp, "\twire\tA_%d;\n"
+				"\tassign\tA_%d = A_%d;\n",
+				clock, clock, clock-1);
+		return;
+	}
+
+	for(unsigned k=0; k<rows.size(); k++)
+		fprintf(fp, "\treg\t[%d:0]\t%s;\t// Bits [%d:%d]\n",
+			rows[k].width-1, rows[k].name.c_str(),
+			rows[k].lsb+rows[k].width-1, rows[k].lsb);
+	if (aux) fprintf(fp, "\treg\tA_%d;\n", clock);
+
+	fprintf(fp, "\n");
+	// A stage may have nothing to register but i_aux
+	if (rows.size() > 0) {
+		for(unsigned k=0; k<rows.size(); k++)
+			fprintf(fp, "\tinitial\t%s = 0;\n",
+				rows[k].name.c_str());
+		fprintf(fp, "%s\tbegin\n", always_reset.c_str());
+		for(unsigned k=0; k<rows.size(); k++)
+			fprintf(fp, "\t\t%s <= 0;\n", rows[k].name.c_str());
+		fprintf(fp, "\tend else if (i_ce)\n\tbegin\n");
+		for(unsigned k=0; k<rows.size(); k++)
+			fprintf(fp, "\t\t%s <= %s;\n", rows[k].name.c_str(),
+				expr[k].c_str());
+		fprintf(fp, "\tend\n\n");
+	}
+
+	if (aux)
+		fprintf(fp, "\tinitial\tA_%d = 0;\n%s"
+		"\t\tA_%d <= 1'b0;\n"
+		"\telse if (i_ce)\n"
+		"\t\tA_%d <= A_%d;\n", clock,
+			always_reset.c_str(),
+			clock, clock, clock-1);
+}
+
+//
+// buildtree
+//
+// Adds rows of partial products together two at a time, with an adder for
+// every pair in every round, much as buildumpy() does.  Each round is one
+// stage of pipe, registered or not.  Here, though, each row carries its own
+// place within the np-bit product, so rows may start and stop anywhere, and
+// nothing is kept above bit np-1.  Rows of a single bit don't count against
+// the depth of the tree: each is added into the first sum of the round that
+// spans it.  Rounds continue until no more than nleft rows are left, which
+// rows then holds, and the number of the last stage is returned.
+//
+int	buildtree(FILE *fp, std::vector<PPROW> &rows, const int np, int clock,
+		const PIPELINE &pipe, const bool aux,
+		const std::string &always_reset, const int nleft) {
+	while((int)rows.size() > nleft) {
+		std::vector<PPROW>	wide, bits, next;
+		std::vector<std::string>	expr;
+		std::vector<std::vector<PPROW> >	sums;
+
+		for(unsigned k=0; k<rows.size(); k++) {
+			if (rows[k].width > 1)
+				wide.push_back(rows[k]);
+			else
+				bits.push_back(rows[k]);
+		}
+
+		for(unsigned k=0; k<wide.size(); k+=2) {
+			std::vector<PPROW>	terms;
+
+			terms.push_back(wide[k]);
+			if (k+1 < wide.size())
+				terms.push_back(wide[k+1]);
+			sums.push_back(terms);
+		}
+
+		for(unsigned k=0; k<bits.size(); k++) {
+			unsigned	s;
+
+			for(s=0; s<sums.size(); s++) {
+				unsigned t;
+
+				for(t=0; t<sums[s].size(); t++)
+					if ((sums[s][t].lsb <= bits[k].lsb)
+						&&(sums[s][t].lsb+sums[s][t].width
+							> bits[k].lsb))
+						break;
+				if (t < sums[s].size())
+					break;
+			}
+
+			if (s < sums.size())
+				sums[s].push_back(bits[k]);
+			else if (sums.size() > 0)
+				sums[0].push_back(bits[k]);
+			else
+				sums.push_back(std::vector<PPROW>(1, bits[k]));
+		}
+
+		clock++;
+		fprintf(fp, "\n\t//\n\t// Round #%d, clock = %d, nrows_in = %d\n\t//\n\n",
+			clock, clock, (int)rows.size());
+
+		// Every sum is as wide as its terms could ever need, unless
+		// that would take it past the top of the product
+		for(unsigned s=0; s<sums.size(); s++) {
+			PPROW		r;
+			std::string	e;
+			int	msb = 0;
+
+			r.lsb = np;
+			for(unsigned t=0; t<sums[s].size(); t++) {
+				if (sums[s][t].lsb < r.lsb)
+					r.lsb = sums[s][t].lsb;
+				if (sums[s][t].lsb+sums[s][t].width-1 > msb)
+					msb = sums[s][t].lsb+sums[s][t].width-1;
+			}
+			msb += lg(sums[s].size());
+			if (msb > np-1)
+				msb = np-1;
+
+			char	rname[64];
+			sprintf(rname, "S_%d_%02d", clock, s);
+			r.name = rname;
+			r.width = msb - r.lsb + 1;
+			next.push_back(r);
+
+			for(unsigned t=0; t<sums[s].size(); t++) {
+				assert(sums[s][t].lsb + sums[s][t].width
+					<= r.lsb + r.width);
+				e += ((t > 0) ? "\n\t\t\t+ " : "")
+					+ alignrow(sums[s][t], r.lsb, r.width);
+			}
+			expr.push_back(e);
+		}
+
+		buildstage(fp, next, expr, clock, regstage(pipe, clock), aux,
+			always_reset);
+
+		rows = next;
+	}
+
+	return clock;
+}
+
+//
+// csacompress
+//
+// One 3:2 (carry-save) compressor across a group of three rows: a sum row,
+// the XOR of the three, and a carry row, their majority moved up one bit.
+// Carries can only come from bits that at least two of the rows hold, so the
+// carry row only spans those.  Returns false if there's no carry at all.
+//
+bool	csacompress(const std::vector<PPROW> &in, const int np,
+		PPROW &s, std::string &sexpr, PPROW &c, std::string &cexpr) {
+	std::vector<int>	lo, hi;
+	int	msb;
+
+	assert(in.size() == 3);
+	for(unsigned k=0; k<in.size(); k++) {
+		lo.push_back(in[k].lsb);
+		hi.push_back(in[k].lsb + in[k].width - 1);
+	}
+	std::sort(lo.begin(), lo.end());
+	std::sort(hi.begin(), hi.end());
+
+	s.lsb = lo[0];
+	s.width = hi[2] - lo[0] + 1;
+	sexpr = "";
+	for(unsigned k=0; k<in.size(); k++)
+		sexpr += ((k > 0) ? " ^ " : "")
+			+ alignrow(in[k], s.lsb, s.width);
+
+	// The carries from bits [hi[1]:lo[1]], sitting one bit higher
+	c.lsb = lo[1] + 1;
+	msb = hi[1] + 1;
+	if (msb > np-1)
+		msb = np-1;
+	c.width = msb - c.lsb + 1;
+	if (c.width <= 0)
+		return false;
+
+	cexpr = "";
+	for(unsigned j=0; j<in.size(); j++)
+	for(unsigned k=j+1; k<in.size(); k++) {
+		// Only pairs that overlap can carry
+		if ((in[j].lsb + in[j].width <= in[k].lsb)
+			||(in[k].lsb + in[k].width <= in[j].lsb))
+			continue;
+		if (cexpr.size() > 0)
+			cexpr += "\n\t\t\t| ";
+		cexpr += "(" + alignrow(in[j], c.lsb-1, c.width)
+			+ " & " + alignrow(in[k], c.lsb-1, c.width) + ")";
+	}
+
+	return true;
+}
+
+//
+// buildcsa
+//
+// Reduces rows of partial products with layers of carry-save compressors,
+// rather than the adders buildtree() uses, so that no carry needs to
+// propagate across the product until the very end.  Each layer takes the
+// rows four at a time, and turns every four into two with a 4:2 compressor
+// (a pair of 3:2 compressors, back to back).  Three rows left over are
+// compressed by a 3:2 alone, while one or two are passed along to the next
+// layer.  Every csa_layers'th layer, and the last, ends a stage of pipe.
+// Once only two rows are left, a final carry-propagate adder, in a stage of
+// its own, adds them together, along with any rows of a single bit, which
+// skip the compressors altogether.  With nleft of two, the final adder is
+// left for the caller.  On return, rows holds the rows left, and the number
+// of the last stage is returned.
+//
+int	buildcsa(FILE *fp, std::vector<PPROW> &rows, const int np, int clock,
+		const PIPELINE &pipe, const bool aux,
+		const std::string &always_reset, const int nleft) {
+	std::vector<PPROW>	wide, bits;
+
+	for(unsigned k=0; k<rows.size(); k++) {
+		if (rows[k].width > 1)
+			wide.push_back(rows[k]);
+		else
+			bits.push_back(rows[k]);
+	}
+
+	const int	nlayers = csalayers(wide.size());
+
+	for(int layer=1; layer <= nlayers; layer++) {
+		std::vector<PPROW>		next;
+		std::vector<std::string>	expr;
+		const bool	endstage = ((layer % csa_layers) == 0)
+					||(layer == nlayers);
+		unsigned	k = 0;
+		int		nhalf = 0;
+		char		str[64];
+
+		if (endstage)
+			clock++;
+		fprintf(fp, "\n\t//\n\t// Compressor layer #%d, ", layer);
+		if (endstage)
+			fprintf(fp, "clock = %d, ", clock);
+		fprintf(fp, "nrows_in = %d\n\t//\n\n", (int)wide.size());
+
+		while(k < wide.size()) {
+			std::vector<PPROW>	in;
+			PPROW		s, c;
+			std::string	sexpr, cexpr;
+
+			const unsigned	n = wide.size() - k;
+
+			if (n < 3) {
+				// Too few to compress, so pass them along
+				for(; k<wide.size(); k++) {
+					next.push_back(wide[k]);
+					expr.push_back(wide[k].name);
+				}
+				break;
+			}
+
+			in.assign(wide.begin()+k, wide.begin()+k+3);
+			k += 3;
+
+			if (n >= 4) {
+				// The first half of a 4:2 compressor, whose
+				// two outputs are compressed together with the
+				// fourth row
+				sprintf(str, "H_%d_%02d", layer, nhalf++);
+				s.name = str;
+				bool	carry = csacompress(in, np,
+						s, sexpr, c, cexpr);
+				fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+					"\tassign\t%s = %s;\n",
+					s.width-1, s.name.c_str(),
+					s.lsb+s.width-1, s.lsb,
+					s.name.c_str(), sexpr.c_str());
+				in.clear();
+				in.push_back(s);
+				if (carry) {
+					sprintf(str, "H_%d_%02d", layer, nhalf++);
+					c.name = str;
+					fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+						"\tassign\t%s = %s;\n",
+						c.width-1, c.name.c_str(),
+						c.lsb+c.width-1, c.lsb,
+						c.name.c_str(), cexpr.c_str());
+					in.push_back(c);
+				}
+				in.push_back(wide[k++]);
+
+				if (in.size() < 3) {
+					for(unsigned j=0; j<in.size(); j++) {
+						next.push_back(in[j]);
+						expr.push_back(in[j].name);
+					}
+					continue;
+				}
+			}
+
+			if (csacompress(in, np, s, sexpr, c, cexpr)) {
+				next.push_back(s);
+				expr.push_back(sexpr);
+				next.push_back(c);
+				expr.push_back(cexpr);
+			} else {
+				next.push_back(s);
+				expr.push_back(sexpr);
+			}
+		}
+
+		if (nhalf > 0)
+			fprintf(fp, "\n");
+
+		// Single bits are left for the final adder to add in
+		const unsigned	nwide = next.size();
+		for(unsigned j=0; j<bits.size(); j++) {
+			next.push_back(bits[j]);
+			expr.push_back(bits[j].name);
+		}
+
+		// Name the outputs of this layer
+		for(unsigned j=0; j<next.size(); j++) {
+			if (endstage)
+				sprintf(str, "S_%d_%02d", clock, j);
+			else if (next[j].name == expr[j])
+				continue;
+			else
+				sprintf(str, "C_%d_%02d", layer, j);
+			next[j].name = str;
+		}
+
+		if (endstage) {
+			buildstage(fp, next, expr, clock, regstage(pipe, clock),
+				aux, always_reset);
+		} else for(unsigned j=0; j<next.size(); j++) {
+			if (next[j].name == expr[j])
+				continue;
+			fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+				"\tassign\t%s = %s;\n",
+				next[j].width-1, next[j].name.c_str(),
+				next[j].lsb+next[j].width-1, next[j].lsb,
+				next[j].name.c_str(), expr[j].c_str());
+		}
+
+		wide.assign(next.begin(), next.begin()+nwide);
+		bits.assign(next.begin()+nwide, next.end());
+	}
+
+	// The final carry-propagate adder
+	assert(wide.size() <= 2);
+	rows = wide;
+	rows.insert(rows.end(), bits.begin(), bits.end());
+	return buildtree(fp, rows, np, clock, pipe, aux, always_reset, nleft);
+}
+
+//
+// buildreduce
+//
+// Reduces rows of partial products to the one row holding the product (or,
+// for a MAC, to the two rows its accumulator adds in), either with
+// buildtree()'s adders or, given -c, buildcsa()'s compressors.  Bits above
+// the top of the product are dropped first.  Returns the number of the last
+// clock.
+//
+int	buildreduce(FILE *fp, std::vector<PPROW> &rows, const int np,
+		const int clock, const PIPELINE &pipe, const bool aux,
+		const std::string &always_reset, const int nleft) {
+	std::string	ustr;
+	int		unused = 0;
+	char		str[64];
+
+	for(unsigned k=0; k<rows.size(); k++) {
+		int	over = rows[k].lsb + rows[k].width - np;
+
+		assert(over < rows[k].width);
+		if (over <= 0)
+			continue;
+		sprintf(str, "[%d:%d]", rows[k].width-1, rows[k].width-over);
+		if (unused > 0)
+			ustr += ", ";
+		else
+			fprintf(fp, "\n");
+		ustr += rows[k].name + str;
+		unused += over;
+
+		std::string	full = rows[k].name;
+		rows[k].width -= over;
+		sprintf(str, "T_%02d", k);
+		rows[k].name = str;
+		fprintf(fp, "\twire\t[%d:0]\t%s;\n"
+			"\tassign\t%s = %s[%d:0];\n",
+			rows[k].width-1, str, str, full.c_str(),
+			rows[k].width-1);
+	}
+
+	if (unused > 0)
+		fprintf(fp,
+		"\t// Make verilator happy\n"
+		"\t// verilator lint_off UNUSED\n"
+		"\twire\t[%d-1:0]\tunused;\n"
+		"\tassign	unused = { %s };\n"
+		"\t// verilator lint_on  UNUSED\n", unused, ustr.c_str());
+
+	if (csa_layers > 0)
+		return buildcsa(fp, rows, np, clock, pipe, aux, always_reset,
+				nleft);
+	return buildtree(fp, rows, np, clock, pipe, aux, always_reset, nleft);
+}
+
+//
+// addbit
+//
+// Adds one to bit b of a constant, carrying as needed.  Anything carried out
+// of the top of the constant is lost.
+//
+void	addbit(std::vector<bool> &bits, unsigned b) {
+	for(; b<bits.size(); b++) {
+		bits[b] = !bits[b];
+		if (bits[b])
+			return;
+	}
+}
+
+//
+// bitconst
+//
+// A constant of as many bits as given, written out one run of ones or zeros
+// at a time, MSB first.
+//
+std::string	bitconst(const std::vector<bool> &bits) {
+	std::string	r;
+	char		str[64];
+
+	for(int k=bits.size()-1; k>=0; ) {
+		const bool	b = bits[k];
+		int		n = 0;
+
+		for(; (k >= 0)&&(bits[k] == b); k--)
+			n++;
+		if (!b)
+			sprintf(str, "%d\'b0", n);
+		else if (n == 1)
+			sprintf(str, "1\'b1");
+		else
+			sprintf(str, "{(%d){1\'b1}}", n);
+		if (r.size() > 0)
+			r += ", ";
+		r += str;
+	}
+	return "{ " + r + " }";
+}
+
+//
+// buildtiledmpy
+//
+// Writes an unsigned core too big for one tile (-t) from smaller unsigned
+// cores, which buildmpy() writes (with buildumpy()) into files of their own.
+// Normally, there's one umpy_TxT for every pair of tiles, one from each
+// operand, and their products are added together with buildreduce().  With
+// --karatsuba, the operands are split in half instead, and three cores of
+// half the size do the work of four: one for the upper halves, one for the
+// lower halves, and one for the difference between the halves of each.  The
+// middle of the product is then the sum of the upper and lower products, less
+// the product of the differences.  The half-sized cores are split the same
+// way in turn, until they fit within a tile.
+//
+void	buildtiledmpy(FILE *fp, const char *name, const int premul,
+		const int na, const int nb, const bool aux,
+		const bool async_reset) {
+	const int	np = na+nb, nstages = stages(premul, na, nb);
+	const PIPELINE	pipe = { nstages, nstages };
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
 	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
 	if (async_reset)
 		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+	std::vector<PPROW>	rows;
+	int		clock, wa, wb, sub, ncores;
+	char		str[64];
+
+	assert(tiled(na, nb));
+	if (karatsuba_flag) {
+		wa = wb = karatsubasize(na, nb);
+		sub = wa/2;
+		ncores = 3;
+	} else {
+		wa = ntiles(na) * tile_size;
+		wb = ntiles(nb) * tile_size;
+		sub = tile_size;
+		ncores = ntiles(na) * ntiles(nb);
+	}
 
 	fprintf(fp,
 "////////////////////////////////////////////////////////////////////////////////\n"
@@ -475,98 +1628,799 @@ void	buildumpy(FILE *fp, char *name, int premul, const int na, const int nb, boo
 "// Project:	%s\n"
 "//\n"
 "// Purpose:\tThis verilog file multiplies two unsigned numbers together,\n"
-"//		without using any hardware acceleration.  This file is\n"
-"//\tcomputer generated, so please (for your sake) don\'t make any edits\n"
-"//\tto this file lest you regenerate it and your edits be lost.\n"
+"//		without using any hardware acceleration, from the products of\n"
+"//\t%s umpy_%dx%d cores.  This file is computer generated, so please\n"
+"//\t(for your sake) don\'t make any edits to this file lest you regenerate\n"
+"//\tit and your edits be lost.\n"
 "//\n"
 "//\n%s"
-"//\n", name, prjname, creator);
+"//\n", name, prjname, (karatsuba_flag) ? "three Karatsuba-Ofman" : "tiled",
+		sub, sub, creator);
 
 	fprintf(fp, "%s", cpyleft);
 
 	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
-		name, (async_reset)?"i_areset_n":"i_reset",
-		(aux)?", i_aux":"", (aux)?", o_aux":"");
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
 	fprintf(fp,
 		"\tparameter\tNA=%d, NB=%d;\n"
 		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
 		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
-		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb,
-		(async_reset)?"i_areset_n":"i_reset");
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb, rstname);
 
 	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
-	fprintf(fp, "\toutput\treg\tsigned\t[(NA+NB-1):0]\to_p;\n");
-	if (aux) fprintf(fp, "\toutput\treg\t\t\t\to_aux;\n");
+	fprintf(fp, "\toutput\twire\tsigned\t[(NA+NB-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
 
 	fprintf(fp, "\n");
 	fprintf(fp, "\tlocalparam NS = (NA < NB) ? NA : NB;\n");
 	fprintf(fp, "\tlocalparam NL = (NA < NB) ? NB : NA;\n");
-	fprintf(fp, "\twire\t[(NS-1):0]\ti_s;\t// Smaller input\n");
-	fprintf(fp, "\twire\t[(NL-1):0]\ti_l;\t// larger input\n");
 
-	fprintf(fp, "\n"
-"\t//\n"
-"\t// Adjust our inputs so that i_s has the fewest bits, and i_b the most\n"
-"\tgenerate if (NA < NB)\n"
-"\tbegin : BITADJ\n"
-"\t\tassign\ti_s = i_a;\n"
-"\t\tassign\ti_l = i_b;\n"
-"\tend else begin\n"
-"\t\tassign\ti_s = i_b;\n"
-"\t\tassign\ti_l = i_a;\n"
-"\tend endgenerate\n\n");
+	fprintf(fp, "\n\t// i_a and i_b, zero extended to a whole number of %s\n",
+		(karatsuba_flag) ? "tiles, and to the same size" : "tiles");
+	fprintf(fp, "\twire\t[%d:0]\tw_a;\n"
+		"\twire\t[%d:0]\tw_b;\n\n", wa-1, wb-1);
+	if (wa > na)
+		fprintf(fp, "\tassign\tw_a = { %d\'b0, i_a };\n", wa-na);
+	else
+		fprintf(fp, "\tassign\tw_a = i_a;\n");
+	if (wb > nb)
+		fprintf(fp, "\tassign\tw_b = { %d\'b0, i_b };\n", wb-nb);
+	else
+		fprintf(fp, "\tassign\tw_b = i_b;\n");
+
+	if (aux)
+		fprintf(fp, "\n\t// The sub-cores don\'t carry i_aux, so their o_aux\n"
+			"\t// outputs are left unused\n"
+			"\t// verilator lint_off UNUSED\n"
+			"\twire\t[%d:0]\tw_aux;\n"
+			"\t// verilator lint_on  UNUSED\n", ncores-1);
 
-	// Build the first tableau row
-	// There are Na elements, each of Nb length
 	clock = 0;
-	fprintf(fp, "\t// Clock zero: build our Tableau only.\n"
-		"\t// There will be one row for every pair of bits in i_a, and each\n"
-		"\t// row will contain (AW+3) bits, to allow\n"
-		"\t// for signed arithmetic manipulation.\n\t//\n");
-	if (aux) fprintf(fp, "\treg\tA_%d;\n", clock);
+	if (karatsuba_flag) {
+		const int	n = wa, h = sub,
+				hstages = stages(premul, h, h);
 
-	for(row=0; row<ns/premul; row++) {
-		fprintf(fp, "\n"
-"\twire\t[%d:0]\tS_0_%02d;\n", nl+premul-1, row);
-		if (premul == 2)
-			fprintf(fp, "\tbimpy ");
-		else
-			fprintf(fp, "\tpremul%d ", premul);
-		fprintf(fp,
-"#(NB) initialmpy_%d_0(i_clk, %s, i_ce, i_s[%d:%d], i_l, S_0_%02d);\n",
-			row,
-			(async_reset)?"i_areset_n":"i_reset",
-			(row*premul+premul-1), (row*premul), row);
+		fprintf(fp, "\n\t// Clock zero: split each operand in half, and find the\n"
+			"\t// difference between its halves.  The product of the two\n"
+			"\t// differences is to be subtracted from the middle of the\n"
+			"\t// product, unless exactly one of them is negative.\n"
+			"\twire\t[%d:0]\tw_da, w_db;\n"
+			"\treg\t[%d:0]\tu_a1, u_a0, u_b1, u_b0, u_da, u_db;\n"
+			"\treg\t\tN_0;\n\n", h, h-1);
+		fprintf(fp, "\tassign\tw_da = { 1\'b0, w_a[%d:%d] } - { 1\'b0, w_a[%d:0] };\n"
+			"\tassign\tw_db = { 1\'b0, w_b[%d:%d] } - { 1\'b0, w_b[%d:0] };\n\n",
+			n-1, h, h-1, n-1, h, h-1);
+		fprintf(fp, "\tinitial\t{ u_a1, u_a0, u_b1, u_b0, u_da, u_db, N_0 } = 0;\n"
+			"%s\tbegin\n"
+			"\t\t{ u_a1, u_a0, u_b1, u_b0 } <= 0;\n"
+			"\t\t{ u_da, u_db, N_0 } <= 0;\n"
+			"\tend else if (i_ce)\n\tbegin\n"
+			"\t\tu_a1 <= w_a[%d:%d];\n"
+			"\t\tu_a0 <= w_a[%d:0];\n"
+			"\t\tu_b1 <= w_b[%d:%d];\n"
+			"\t\tu_b0 <= w_b[%d:0];\n"
+			"\t\tu_da <= (w_da[%d]) ? (-w_da[%d:0]) : w_da[%d:0];\n"
+			"\t\tu_db <= (w_db[%d]) ? (-w_db[%d:0]) : w_db[%d:0];\n"
+			"\t\tN_0  <= !(w_da[%d] ^ w_db[%d]);\n"
+			"\tend\n\n", always_reset.c_str(),
+			n-1, h, h-1, n-1, h, h-1,
+			h, h-1, h-1, h, h-1, h-1, h, h);
+
+		if (aux)
+			fprintf(fp, "\treg\tA_%d;\n"
+			"\tinitial\tA_%d = 0;\n%s"
+			"\t\tA_%d <= 1'b0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tA_%d <= i_aux;\n", clock, clock,
+			always_reset.c_str(), clock, clock);
+
+		const char	*core[3] = { "hi", "lo", "md" },
+				*ops[3][2] = { { "u_a1", "u_b1" },
+					{ "u_a0", "u_b0" },
+					{ "u_da", "u_db" } },
+				*prod[3] = { "P_H", "P_L", "P_M" };
+
+		fprintf(fp, "\n\t// Clocks one through %d: the three half-sized products\n",
+			hstages);
+		for(int k=0; k<3; k++) {
+			fprintf(fp, "\twire\t[%d:0]\t%s;\n"
+				"\tumpy_%dx%d\t%s(i_clk, %s, i_ce, %s, %s,",
+				2*h-1, prod[k], h, h, core[k], rstname,
+				ops[k][0], ops[k][1]);
+			if (aux)
+				fprintf(fp, " 1\'b0, %s, w_aux[%d]);\n", prod[k], k);
+			else
+				fprintf(fp, " %s);\n", prod[k]);
+		}
+
+		// Delay the sign of the difference product to match
+		for(clock=1; clock<=hstages; clock++) {
+			std::vector<PPROW>	sgn(1);
+			std::vector<std::string>	expr(1);
+
+			fprintf(fp, "\n");
+			sprintf(str, "N_%d", clock);
+			sgn[0].name = str;
+			sgn[0].lsb = h;
+			sgn[0].width = 1;
+			sprintf(str, "N_%d", clock-1);
+			expr[0] = str;
+			buildstage(fp, sgn, expr, clock, true, aux, always_reset);
+		}
+		clock = hstages;
+
+		// The upper and lower products, side by side, and again in the
+		// middle.  The difference product is subtracted by inverting
+		// it, and adding one more at the bottom.
+		fprintf(fp, "\n\t// The rows to add: the upper and lower products, both\n"
+			"\t// again in the middle, and the difference product\n"
+			"\twire\t[%d:0]\tR_HL;\n"
+			"\twire\t[%d:0]\tR_M;\n\n"
+			"\tassign\tR_HL = { P_H, P_L };\n"
+			"\tassign\tR_M  = { %d\'b0, P_M } ^ {(%d){N_%d}};\n",
+			2*n-1, 3*h-1, h, 3*h, clock);
+
+		const char	*rname[5] = { "R_HL", "P_H", "P_L", "R_M", "" };
+		const int	rlsb[5] = { 0, h, h, h, h },
+				rwidth[5] = { 2*n, 2*h, 2*h, 3*h, 1 };
+
+		sprintf(str, "N_%d", clock);
+		for(int k=0; k<5; k++) {
+			PPROW	r;
+
+			r.name = (k < 4) ? rname[k] : str;
+			r.lsb = rlsb[k];
+			r.width = rwidth[k];
+			rows.push_back(r);
+		}
+	} else {
+		// Each row gathers every other tile product along one tile of
+		// the operand with the fewest, since those products don't
+		// overlap
+		const int	tstages = stages(premul, sub, sub);
+		const bool	swap = (ntiles(na) > ntiles(nb));
+		const int	tx = (swap) ? ntiles(nb) : ntiles(na),
+				ty = (swap) ? ntiles(na) : ntiles(nb);
+		const char	*xs = (swap) ? "w_b" : "w_a",
+				*ys = (swap) ? "w_a" : "w_b";
+
+		fprintf(fp, "\n\t// Clocks zero through %d: the product of every pair of tiles\n",
+			tstages-1);
+		for(int i=0; i<tx; i++)
+		for(int j=0; j<ty; j++) {
+			fprintf(fp, "\twire\t[%d:0]\tP_%02d_%02d;\n"
+				"\tumpy_%dx%d\ttile_%02d_%02d(i_clk, %s, i_ce, "
+				"%s[%d:%d], %s[%d:%d],",
+				2*sub-1, i, j, sub, sub, i, j, rstname,
+				xs, (i+1)*sub-1, i*sub,
+				ys, (j+1)*sub-1, j*sub);
+			if (aux)
+				fprintf(fp, " 1\'b0, P_%02d_%02d, w_aux[%d]);\n",
+					i, j, i*ty+j);
+			else
+				fprintf(fp, " P_%02d_%02d);\n", i, j);
+		}
+
+		if (aux) {
+			fprintf(fp, "\n\treg\tA_%d;\n"
+			"\tinitial\tA_%d = 0;\n%s"
+			"\t\tA_%d <= 1'b0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tA_%d <= i_aux;\n", clock, clock,
+			always_reset.c_str(), clock, clock);
+
+			// Delay i_aux to match
+			for(clock=1; clock<tstages; clock++)
+				buildstage(fp, std::vector<PPROW>(),
+					std::vector<std::string>(), clock,
+					true, aux, always_reset);
+		}
+		clock = tstages-1;
+
+		fprintf(fp, "\n\t// The rows to add: every other tile product, side by side\n");
+		for(int i=0; i<tx; i++)
+		for(int p=0; (p<2)&&(p<ty); p++) {
+			PPROW	r;
+
+			sprintf(str, "R_%02d_%d", i, p);
+			r.name = str;
+			r.lsb = (i+p) * sub;
+			r.width = 0;
+			fprintf(fp, "\twire\t[%d:0]\t%s;\n\tassign\t%s = {",
+				2*sub*((ty-p+1)/2)-1, str, str);
+			for(int j=ty-1; j>=p; j--) {
+				if ((j&1) != p)
+					continue;
+				fprintf(fp, "%s P_%02d_%02d",
+					(r.width > 0) ? ",":"", i, j);
+				r.width += 2*sub;
+			}
+			fprintf(fp, " };\n");
+			rows.push_back(r);
+		}
+		assert((int)rows.size() == tilerows(na, nb));
 	}
-	if (ns%premul) {// Do one extra row, to capture the last bit of a
-		fprintf(fp, "\t//Extra (odd) row\n");
-		fprintf(fp,
-"\twire\t[%d:0]\tS_0_%02d;\n", nl+premul-1, row);
+
+	clock = buildreduce(fp, rows, np, clock, pipe, aux, always_reset, 1);
+
+	// The core descriptions depend upon this
+	assert(clock + 1 == pipe.nstages);
+	assert((rows[0].lsb == 0)&&(rows[0].width == np));
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n", rows[0].name.c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	buildformal(fp, pipe, aux, async_reset, false);
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildlutrows
+//
+// Writes the LUT rows of one strip of a hard multiplier core: bits
+// [alsb+na-1:alsb] of i_a by bits [blsb+nb-1:blsb] of i_b, with one bimpy
+// (or premulN) for every premul bits of the narrower side, just as
+// buildumpy() builds its tableau.  Each row is added to rows.
+//
+void	buildlutrows(FILE *fp, std::vector<PPROW> &rows, const int premul,
+		const int alsb, const int na, const int blsb, const int nb,
+		const char *rstname) {
+	const bool	swap = (nb < na);
+	const char	*sname = (swap) ? "i_b" : "i_a",
+			*lname = (swap) ? "i_a" : "i_b";
+	const int	slsb = (swap) ? blsb : alsb, ns = (swap) ? nb : na,
+			llsb = (swap) ? alsb : blsb, nl = (swap) ? na : nb;
+
+	if ((na == 0)||(nb == 0))
+		return;
+
+	for(int k=0; k<ns; k+=premul) {
+		const int	nbits = (ns-k < premul) ? ns-k : premul;
+		PPROW		r;
+		char		str[64];
+
+		sprintf(str, "S_0_%02d", (int)rows.size());
+		r.name = str;
+		r.lsb = slsb + k + llsb;
+		r.width = nl + premul;
+
+		fprintf(fp, "\twire\t[%d:0]\t%s;\n", r.width-1, str);
 		if (premul == 2)
 			fprintf(fp, "\tbimpy ");
 		else
 			fprintf(fp, "\tpremul%d ", premul);
-		fprintf(fp,
-	"#(NB) initialmpy_%d_0(i_clk, %s, i_ce, { {(%d){1\'b0}}, i_s[%d:%d]}, i_l, S_0_%02d);\n",
-			row,
-			(async_reset)?"i_areset_n":"i_reset",
-			(row*premul+premul)-ns, ns-1,
-			(row*premul), row);
-	} sz = (nl+premul); lastsz = sz;
+		fprintf(fp, "#(%d) lutmpy_%d(i_clk, %s, i_ce, ", nl,
+			(int)rows.size(), rstname);
+		if (nbits < premul)
+			fprintf(fp, "{ %d\'b0, %s[%d:%d] }", premul-nbits,
+				sname, slsb+k+nbits-1, slsb+k);
+		else
+			fprintf(fp, "%s[%d:%d]", sname, slsb+k+nbits-1, slsb+k);
+		fprintf(fp, ", %s[%d:%d], %s);\n", lname, llsb+nl-1, llsb, str);
 
-	if (aux)
-		fprintf(fp, "\n\tinitial\tA_%d = 0;\n%s"
-		"\t\tA_%d <= 1'b0;\n"
-		"\telse if (i_ce)\n"
-		"\t\tA_%d <= i_aux;\n", clock,
-		always_reset.c_str(), clock, clock);
-	nrows = (ns/premul)+((ns%premul)?1:0); nbits = nl+premul, nzros=premul;
+		rows.push_back(r);
+	}
+}
 
-	// assert(nrows == npremul(premul, ns, nl));
+//
+// builddspmpy
+//
+// Writes an unsigned core that leaves as much of the product as it can to
+// the hard (DSP) multipliers of --dsp: each a plain, registered "*" of a
+// few bits of i_a by a few bits of i_b, for the synthesis tool to map onto a
+// DSP block.  The strips along the top of i_a and of i_b that don't fill a
+// whole hard multiplier are built from LUTs instead, as buildumpy() would.
+// Every row, from either, is then added together by buildreduce().
+//
+void	builddspmpy(FILE *fp, const char *name, const int premul,
+		const int na, const int nb, const bool aux,
+		const bool async_reset) {
+	const int	np = na+nb, nstages = stages(premul, na, nb);
+	const PIPELINE	pipe = { nstages, nstages };
+	const DSPTILES	t = dsptiles(na, nb);
+	const int	ca = t.ka*t.wa, cb = t.kb*t.wb;
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+	std::vector<PPROW>	rows, drows;
+	std::vector<std::string>	dexpr;
+	int		clock;
+	char		str[64];
 
-	while(nrows > 1) {
-		lastsz = sz;
-		fprintf(fp, "\n\t//\n\t// Round #%d, clock = %d, nz = %d, nbits = %d, nrows_in = %d\n\t//\n",
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies two unsigned numbers together,\n"
+"//		using %d hard multipl%s of %dx%d bits for as much of the\n"
+"//\tproduct as %s, and LUTs for the rest.  This file is computer\n"
+"//\tgenerated, so please (for your sake) don\'t make any edits to this\n"
+"//\tfile lest you regenerate it and your edits be lost.\n"
+"//\n"
+"//\n%s"
+"//\n", name, prjname, t.ka*t.kb, (t.ka*t.kb != 1) ? "iers":"ier",
+		t.wa, t.wb, (t.ka*t.kb != 1) ? "they cover":"it covers",
+		creator);
+
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb, rstname);
+
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\tsigned\t[(NA+NB-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	fprintf(fp, "\n");
+	fprintf(fp, "\tlocalparam NS = (NA < NB) ? NA : NB;\n");
+	fprintf(fp, "\tlocalparam NL = (NA < NB) ? NB : NA;\n");
+
+	// The hard multipliers, zero extended so that each multiply is as
+	// wide as its product
+	clock = 0;
+	fprintf(fp, "\n\t// Clock zero: the hard multiplies, and the LUT rows of\n"
+		"\t// whatever they leave over\n");
+	for(int i=0; i<t.ka; i++)
+	for(int j=0; j<t.kb; j++) {
+		PPROW	r;
+
+		sprintf(str, "D_%02d_%02d", i, j);
+		r.name = str;
+		r.lsb = i*t.wa + j*t.wb;
+		r.width = t.wa + t.wb;
+		drows.push_back(r);
+
+		sprintf(str, "{ %d\'b0, i_a[%d:%d] } * { %d\'b0, i_b[%d:%d] }",
+			t.wb, (i+1)*t.wa-1, i*t.wa,
+			t.wa, (j+1)*t.wb-1, j*t.wb);
+		dexpr.push_back(str);
+	}
+	buildstage(fp, drows, dexpr, clock, true, false, always_reset);
+
+	// The top of i_a by all of i_b, and then the rest of i_a by the top
+	// of i_b
+	buildlutrows(fp, rows, premul, ca, na-ca, 0, nb, rstname);
+	buildlutrows(fp, rows, premul, 0, ca, cb, nb-cb, rstname);
+	rows.insert(rows.end(), drows.begin(), drows.end());
+	assert((int)rows.size() == dsprows(premul, na, nb));
+
+	if (aux)
+		fprintf(fp, "\n\treg\tA_%d;\n"
+		"\tinitial\tA_%d = 0;\n%s"
+		"\t\tA_%d <= 1'b0;\n"
+		"\telse if (i_ce)\n"
+		"\t\tA_%d <= i_aux;\n", clock, clock,
+		always_reset.c_str(), clock, clock);
+
+	clock = buildreduce(fp, rows, np, clock, pipe, aux, always_reset, 1);
+
+	// The core descriptions depend upon this
+	assert(clock + 1 == pipe.nstages);
+	assert((rows[0].lsb == 0)&&(rows[0].width == np));
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n", rows[0].name.c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	buildformal(fp, pipe, aux, async_reset, false);
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// tableaurows
+//
+// The rows of the tableau, one for every premul bits of i_s, each the sum of
+// that many shifted copies of i_l, written as expressions of i_s and i_l for
+// buildstage().  With sgn, they're Baugh-Wooley rows instead: every row but
+// the last inverts the product of its bit of i_s with the sign bit of i_l, and
+// the last (the sign bit of i_s) inverts the product with every other bit.
+// Each inversion of a negative bit adds one at that bit, so the constant
+// making up for them all, modulo 2^np, is added into the first and last rows.
+// Only the last row gets any wider for it, and then only when np is wider
+// than the product.
+//
+// A truncated core (see truncation()) keeps only the columns from lo up, and
+// adds comp to that constant.  Rows with nothing left are dropped, the rest
+// start no lower than lo, and the constant is split between the first row
+// kept, below the last row, and the last row, which is widened out to np.
+// The first row takes one more bit to hold its share.  With var, the bits of
+// column lo-1 are added in at lo, and every row takes one more bit for those.
+//
+void	tableaurows(std::vector<PPROW> &rows, std::vector<std::string> &expr,
+		const int premul, const int ns, const int nl, const bool sgn,
+		const int np, const int lo, const bool var, const long comp) {
+	const int	nrows = (ns+premul-1)/premul;
+	const bool	whole = (lo == 0)&&(comp == 0);
+	const int	first = nrows - truncrows(premul, ns, nl, lo, var),
+			split = std::max(premul * (nrows-1), lo);
+	std::vector<bool>	kbits(np, false);
+
+	if (!whole) {
+		if (sgn) {
+			addbit(kbits, nl-1);
+			addbit(kbits, ns-1);
+			for(int k=ns+nl-1; k<np; k++)
+				addbit(kbits, k);
+		}
+		for(int k=0; k<np; k++)
+			if (((unsigned long)comp >> k) & 1)
+				addbit(kbits, k);
+		for(int k=0; k<lo; k++)
+			assert(!kbits[k]);
+	}
+
+	for(int row=first; row<nrows; row++) {
+		const int	rlsb = premul * row,
+				lsb = std::max(rlsb, lo);
+		int		width = rlsb + nl+premul - lsb + ((var)?1:0);
+		std::vector<bool>	cbits;
+		std::string	e;
+		char		str[64];
+		PPROW		r;
+
+		if (whole) {
+			if ((sgn)&&(row == nrows-1))
+				width = std::max(nl+premul, np-lsb);
+		} else if (row == nrows-1) {
+			if (std::find(kbits.begin()+lsb, kbits.end(), true)
+					!= kbits.end())
+				width = std::max(width, np-lsb);
+		} else if ((row == first)&&(std::find(kbits.begin()+lsb,
+				kbits.begin()+split, true)
+					!= kbits.begin()+split))
+			width++;
+		cbits.assign(width, false);
+
+		for(int k=0; (k<premul)&&(rlsb+k<ns); k++) {
+			const int	b = rlsb+k, jlo = std::max(0, lo-b);
+			std::vector<bool>	mask(nl, (b == ns-1));
+
+			mask[nl-1] = (b < ns-1);
+			if (!((sgn)&&(nl > 1)))
+				mask.assign(nl, false);
+
+			if (jlo < nl) {
+				if (e.size() > 0)
+					e += "\n\t\t\t+ ";
+				sprintf(str, "{ %d\'b0, ",
+					width-(nl-jlo)-(b+jlo-lsb));
+				e += str;
+				if (jlo == 0)
+					sprintf(str, "((i_s[%d]) ? i_l : %d\'b0)",
+						b, nl);
+				else
+					sprintf(str, "((i_s[%d]) ? i_l[%d:%d] : %d\'b0)",
+						b, nl-1, jlo, nl-jlo);
+				if ((sgn)&&(nl > 1))
+					e = e + "(" + str + " ^ " + bitconst(
+						std::vector<bool>(mask.begin()+jlo,
+							mask.end())) + ")";
+				else
+					e += str;
+				if (b+jlo > lsb) {
+					sprintf(str, ", %d\'b0", b+jlo-lsb);
+					e += str;
+				}
+				e += " }";
+			}
+
+			// The bit of this copy in column lo-1, moved up to lo
+			if ((var)&&(jlo > 0)&&(jlo <= nl)) {
+				if (e.size() > 0)
+					e += "\n\t\t\t+ ";
+				sprintf(str, "{ %d\'b0, (i_s[%d] & i_l[%d])%s }",
+					width-1, b, jlo-1,
+					(mask[jlo-1]) ? " ^ 1\'b1" : "");
+				e += str;
+			}
+		}
+
+		if (whole) {
+			if ((sgn)&&(row == 0)) {
+				addbit(cbits, nl-1);
+				addbit(cbits, ns-1);
+			} if ((sgn)&&(row == nrows-1)) {
+				// Less 2^(ns+nl-1), as ones from there up to np
+				for(int k=ns+nl-1; k<np; k++)
+					addbit(cbits, k-lsb);
+			}
+		} else for(int k=lsb; (k<np)&&(k<lsb+width); k++) {
+			if ((row == nrows-1)&&(kbits[k]))
+				cbits[k-lsb] = true;
+			else if ((row == first)&&(k < split)&&(kbits[k]))
+				cbits[k-lsb] = true;
+		}
+		if (std::find(cbits.begin(), cbits.end(), true)
+				!= cbits.end())
+			e += "\n\t\t\t+ " + bitconst(cbits);
+
+		sprintf(str, "S_0_%02d", row-first);
+		r.name = str;
+		r.lsb = lsb;
+		r.width = width;
+		rows.push_back(r);
+		expr.push_back(e);
+	}
+}
+
+//
+// buildbitadj
+//
+// Declares i_s and i_l, the narrower and the wider of i_a and i_b, for the
+// cores whose tableau has a row for every bit (or premul bits) of i_s.
+//
+void	buildbitadj(FILE *fp) {
+	fprintf(fp, "\n");
+	fprintf(fp, "\tlocalparam NS = (NA < NB) ? NA : NB;\n");
+	fprintf(fp, "\tlocalparam NL = (NA < NB) ? NB : NA;\n");
+	fprintf(fp, "\twire\t[(NS-1):0]\ti_s;\t// Smaller input\n");
+	fprintf(fp, "\twire\t[(NL-1):0]\ti_l;\t// larger input\n");
+
+	fprintf(fp, "\n"
+"\t//\n"
+"\t// Adjust our inputs so that i_s has the fewest bits, and i_b the most\n"
+"\tgenerate if (NA < NB)\n"
+"\tbegin : BITADJ\n"
+"\t\tassign\ti_s = i_a;\n"
+"\t\tassign\ti_l = i_b;\n"
+"\tend else begin\n"
+"\t\tassign\ti_s = i_b;\n"
+"\t\tassign\ti_l = i_a;\n"
+"\tend endgenerate\n\n");
+}
+
+//
+// buildaux0
+//
+// A_0, the first register of the aux pipeline, taking i_aux on the same
+// clock as the tableau.  Each stage after it delays A_0 by one more clock.
+//
+void	buildaux0(FILE *fp, const std::string &always_reset) {
+	fprintf(fp, "\treg\tA_0;\n"
+		"\tinitial\tA_0 = 0;\n%s"
+		"\t\tA_0 <= 1'b0;\n"
+		"\telse if (i_ce)\n"
+		"\t\tA_0 <= i_aux;\n", always_reset.c_str());
+}
+
+//
+// buildfpipe
+//
+// The formal reference of a core checked against a result found the simple
+// way, as result gives it, width bits wide.  f_pipe delays it by the core's
+// F_DELAY clocks, and f_valid marks once it holds one.  The core then checks
+// its outputs against the top of f_pipe.
+//
+void	buildfpipe(FILE *fp, const int delay, const char *width,
+		const char *result, const std::string &always_reset) {
+	fprintf(fp,
+	"\tlocalparam\tF_DELAY = %d;\n"
+	"\treg\t[F_DELAY*(%s)-1:0]\tf_pipe;\n"
+	"\treg\t[F_DELAY-1:0]\tf_valid;\n\n", delay, width);
+	fprintf(fp,
+	"\tinitial\tf_pipe = 0;\n"
+	"\tinitial\tf_valid = 0;\n%s"
+	"\tbegin\n"
+		"\t\tf_pipe <= 0;\n"
+		"\t\tf_valid <= 0;\n"
+	"\tend else if (i_ce)\n", always_reset.c_str());
+	if (delay > 1)
+		fprintf(fp,
+	"\tbegin\n"
+		"\t\tf_pipe <= { f_pipe[(F_DELAY-1)*(%s)-1:0], %s };\n"
+		"\t\tf_valid <= { f_valid[F_DELAY-2:0], 1\'b1 };\n"
+	"\tend\n\n", width, result);
+	else
+		fprintf(fp,
+	"\tbegin\n"
+		"\t\tf_pipe <= %s;\n"
+		"\t\tf_valid <= 1\'b1;\n"
+	"\tend\n\n", result);
+}
+
+//
+// buildumpy
+//
+// Writes the unsigned core.  With sgn, it writes a signed core instead, from
+// the same tableau but for a few bits inverted in each row, and a constant
+// added in to make up for them.
+//
+void	buildumpy(FILE *fp, char *name, int premul, const int na, const int nb, const bool sgn, bool aux, bool async_reset) {
+	int	row, clock, nbits, nrows, nzros, maxbits = na+nb,
+		unused = 0, sz = 0, lastsz;
+	std::string	ustr;
+	int	ns, nl;
+	ns = (na < nb) ? na : nb;
+	nl = (na < nb) ? nb : na;
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+	const PIPELINE	pipe = { stages(premul, ns, nl),
+				latency(premul, ns, nl, sgn) };
+
+	if ((!sgn)&&(dsp_na > 0)) {
+		builddspmpy(fp, name, premul, na, nb, aux, async_reset);
+		return;
+	} else if ((!sgn)&&(tiled(na, nb))) {
+		buildtiledmpy(fp, name, premul, na, nb, aux, async_reset);
+		return;
+	}
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"%s"
+"//\n"
+"//\n%s"
+"//\n", name, prjname, (sgn)
+? "// Purpose:\tThis verilog file multiplies two signed numbers together,\n"
+"//		without using any hardware acceleration, from Baugh-Wooley\n"
+"//\tsign corrected partial products.  This file is computer generated, so\n"
+"//\tplease (for your sake) don\'t make any edits to this file lest you\n"
+"//\tregenerate it and your edits be lost.\n"
+: "// Purpose:\tThis verilog file multiplies two unsigned numbers together,\n"
+"//		without using any hardware acceleration.  This file is\n"
+"//\tcomputer generated, so please (for your sake) don\'t make any edits\n"
+"//\tto this file lest you regenerate it and your edits be lost.\n",
+		creator);
+
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
+		name, (async_reset)?"i_areset_n":"i_reset",
+		(aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb,
+		(async_reset)?"i_areset_n":"i_reset");
+
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\treg\tsigned\t[(NA+NB-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\treg\t\t\t\to_aux;\n");
+
+	buildbitadj(fp);
+
+	// Build the first tableau row
+	// There are Na elements, each of Nb length
+	clock = 0;
+	fprintf(fp, "\t// Clock zero: build our Tableau only.\n"
+		"\t// There will be one row for every pair of bits in i_a, and each\n"
+		"\t// row will contain (AW+3) bits, to allow\n"
+		"\t// for signed arithmetic manipulation.\n\t//\n");
+	if (sgn) {
+		std::vector<PPROW>	srows;
+		std::vector<std::string>	expr;
+
+		fprintf(fp, "\t// The sign bits of i_s and i_l are inverted where\n"
+			"\t// they meet the other operand, and the constant that\n"
+			"\t// makes up for it is added to the first and last rows.\n"
+			"\t//\n");
+		tableaurows(srows, expr, premul, ns, nl, true, maxbits, 0, false, 0);
+
+		buildstage(fp, srows, expr, clock, regstage(pipe, 0), false,
+			always_reset);
+
+		if ((aux)&&(!regstage(pipe, 0)))
+			fprintf(fp, "\n\twire\tA_%d;\n"
+				"\tassign\tA_%d = i_aux;\n", clock, clock);
+		else if (aux)
+			fprintf(fp, "\treg\tA_%d;\n"
+			"\tinitial\tA_%d = 0;\n%s"
+			"\t\tA_%d <= 1'b0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tA_%d <= i_aux;\n", clock, clock,
+			always_reset.c_str(), clock, clock);
+	} else if (!regstage(pipe, 0)) {
+		// Without a register, there's no need for bimpy: each row is
+		// just the sum of premul shifted copies of i_l
+		for(row=0; row*premul<ns; row++) {
+			fprintf(fp, "\n\twire\t[%d:0]\tS_0_%02d;\n"
+				"\tassign\tS_0_%02d = ", nl+premul-1, row, row);
+			for(int k=0; (k<premul)&&(row*premul+k<ns); k++) {
+				fprintf(fp, "%s{ %d\'b0, ((i_s[%d]) ? i_l : %d\'b0)",
+					(k > 0) ? "\n\t\t\t+ " : "",
+					premul-k, row*premul+k, nl);
+				if (k > 0)
+					fprintf(fp, ", %d\'b0", k);
+				fprintf(fp, " }");
+			}
+			fprintf(fp, ";\n");
+		}
+
+		if (aux)
+			fprintf(fp, "\n\twire\tA_%d;\n"
+				"\tassign\tA_%d = i_aux;\n", clock, clock);
+	} else {
+		if (aux) fprintf(fp, "\treg\tA_%d;\n", clock);
+
+		for(row=0; row<ns/premul; row++) {
+			fprintf(fp, "\n"
+	"\twire\t[%d:0]\tS_0_%02d;\n", nl+premul-1, row);
+			if (premul == 2)
+				fprintf(fp, "\tbimpy ");
+			else
+				fprintf(fp, "\tpremul%d ", premul);
+			fprintf(fp,
+	"#(NB) initialmpy_%d_0(i_clk, %s, i_ce, i_s[%d:%d], i_l, S_0_%02d);\n",
+				row,
+				(async_reset)?"i_areset_n":"i_reset",
+				(row*premul+premul-1), (row*premul), row);
+		}
+		if (ns%premul) {// Do one extra row, to capture the last bit of a
+			fprintf(fp, "\t//Extra (odd) row\n");
+			fprintf(fp,
+	"\twire\t[%d:0]\tS_0_%02d;\n", nl+premul-1, row);
+			if (premul == 2)
+				fprintf(fp, "\tbimpy ");
+			else
+				fprintf(fp, "\tpremul%d ", premul);
+			fprintf(fp,
+		"#(NB) initialmpy_%d_0(i_clk, %s, i_ce, { {(%d){1\'b0}}, i_s[%d:%d]}, i_l, S_0_%02d);\n",
+				row,
+				(async_reset)?"i_areset_n":"i_reset",
+				(row*premul+premul)-ns, ns-1,
+				(row*premul), row);
+		} sz = (nl+premul); lastsz = sz;
+
+		if (aux)
+			fprintf(fp, "\n\tinitial\tA_%d = 0;\n%s"
+			"\t\tA_%d <= 1'b0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tA_%d <= i_aux;\n", clock,
+			always_reset.c_str(), clock, clock);
+	}
+	nrows = (ns/premul)+((ns%premul)?1:0); nbits = nl+premul, nzros=premul;
+
+	// assert(nrows == npremul(premul, ns, nl));
+
+	if ((sgn)||(csa_layers > 0)||(pipe.delay < pipe.nstages)) {
+		std::vector<PPROW>	rows;
+		char	str[64];
+
+		for(row=0; row<nrows; row++) {
+			PPROW	r;
+
+			sprintf(str, "S_0_%02d", row);
+			r.name = str;
+			r.lsb = premul * row;
+			r.width = nl + premul;
+			rows.push_back(r);
+		}
+
+		clock = buildreduce(fp, rows, maxbits, clock, pipe, aux,
+				always_reset, 1);
+
+		// The core descriptions depend upon this
+		assert(clock + 1 == pipe.nstages);
+		assert((rows[0].lsb == 0)&&(rows[0].width == maxbits));
+
+		fprintf(fp, "\n\tassign\to_p = %s;\n", rows[0].name.c_str());
+		if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+		buildformal(fp, pipe, aux, async_reset, sgn);
+		fprintf(fp, "\nendmodule\n");
+		return;
+	}
+
+	while(nrows > 1) {
+		char	str[64];
+
+		lastsz = sz;
+		fprintf(fp, "\n\t//\n\t// Round #%d, clock = %d, nz = %d, nbits = %d, nrows_in = %d\n\t//\n",
 			clock+1, clock+1, nzros, nbits, nrows);
 		clock++; fprintf(fp, "\n");
 		for(row=0; row<(nrows+1)/2; row++) {
@@ -614,15 +2468,16 @@ void	buildumpy(FILE *fp, char *name, int premul, const int na, const int nb, boo
 				fprintf(fp, "// Adding to unused: %d, %d\n", nzros+nbits+1, maxbits);
 				unused += lastsz - (maxbits-nzros);
 				fprintf(fp, "[%d:0]", maxbits-1-nzros);
-				if (ustr[0])
-					strcat(ustr, ", ");
-				sprintf(ustr, "%sS_%d_%02d[%d:%d]",
-					ustr, clock-1, 2*row+1,
+				if (ustr.size() > 0)
+					ustr += ", ";
+				sprintf(str, "S_%d_%02d[%d:%d]",
+					clock-1, 2*row+1,
 					lastsz-1, maxbits-nzros);
+				ustr += str;
 			}
 			fprintf(fp, ", %d\'b0 };\n", nzros);
 			if (unused)
-				fprintf(fp, "\n// unused = %d, ustr = %s\n", unused, ustr);
+				fprintf(fp, "\n// unused = %d, ustr = %s\n", unused, ustr.c_str());
 		}
 		if (nrows&1) {
 			fprintf(fp, "\t\tS_%d_%02d <= { ",
@@ -651,94 +2506,2606 @@ void	buildumpy(FILE *fp, char *name, int premul, const int na, const int nb, boo
 	fprintf(fp, "\n\tassign\to_p = S_%d_00[(NA+NB-1):0];\n", clock);
 	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
 
-	// assert(clock + 1 == stages(premul, ns, nl));
+	// The core descriptions depend upon this
+	assert(clock + 1 == stages(premul, ns, nl));
 
+	// Small tableaus never reach the top of the product, so there may
+	// be nothing left over
+	if (unused > 0)
 	fprintf(fp, "\n"
 	"\t// Make verilator happy\n"
 	"\t// verilator lint_off UNUSED\n"
 	"\twire\t[%d-1:0]\tunused;\n"
 	"\tassign	unused = { %s };\n"
-	"\t// verilator lint_on  UNUSED\n\n", unused, ustr);
+	"\t// verilator lint_on  UNUSED\n\n", unused, ustr.c_str());
 
-	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	buildformal(fp, pipe, aux, async_reset, false);
+	fprintf(fp, "\nendmodule\n");
+}
 
-	fprintf(fp, "\treg\tf_past_valid;\n"
-	"\tinitial\tf_past_valid = 0;\n"
-	"\talways @(posedge i_clk)\n"
-	"\t\tf_past_valid <= 1\'b1;\n\n");
+//
+// buildmac
+//
+// Writes a multiply-accumulate core: the unsigned core's tableau (or, with
+// sgn, its Baugh-Wooley rows, sign corrected out to NACC bits), reduced to
+// two rows just as buildumpy() would, and then added to the accumulator in
+// the one stage that would otherwise have added those two rows together.
+// The accumulator is compressed together with them first, so the stage
+// still holds only the one carry chain, and the MAC takes no more clocks
+// than the multiply.  i_clr travels along with i_a and i_b, and restarts the
+// sum from their product once it gets there.
+//
+void	buildmac(FILE *fp, const char *name, const int premul, const int na,
+		const int nb, const int nacc, const bool sgn, const bool aux,
+		const bool async_reset) {
+	const int	ns = (na < nb) ? na : nb, nl = (na < nb) ? nb : na;
+	const int	nstages = macstages(premul, ns, nl);
+	const PIPELINE	pipe = { nstages, nstages };
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	std::vector<PPROW>	rows;
+	std::vector<std::string>	expr;
+	int	clock;
 
-	if (aux) {
-		fprintf(fp,
-		"\twire	[%d+1:0]\tf_auxpipe;\n"
-		"\tassign\tf_auxpipe\t= { ", clock);
-		for(int k=clock; k>=0; k--)
-			fprintf(fp, "A_%d,", k);
-		fprintf(fp, " i_aux };\n\n");
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
 
-		fprintf(fp, "\tinitial\tassume(!i_aux);\n");
-		fprintf(fp, "\talways @(posedge i_clk)\n"
-			"\tif ((%s)||((f_past_valid)&&($past(%s))))\n"
-			"\t\tassume(!i_aux);\n\n",
-			(async_reset)? "!i_areset_n":"i_reset",
-			(async_reset)? "!i_areset_n":"i_reset");
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies two %s numbers together, and\n"
+"//		adds their product to a running sum of %d bits, within the\n"
+"//	one adder tree.  Raising i_clr with an i_a and i_b starts a new sum\n"
+"//	from their product.  This file is computer generated, so please (for\n"
+"//	your sake) don\'t make any edits to this file lest you regenerate it\n"
+"//	and your edits be lost.\n"
+"//\n"
+"%s"
+"//\n", name, prjname, (sgn) ? "signed" : "unsigned", nacc, creator);
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_clr, i_a, i_b%s, o_acc%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d, NACC=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce, i_clr;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb, nacc,
+		rstname);
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t\t[(NACC-1):0]\to_acc;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	buildbitadj(fp);
+
+	fprintf(fp, "\t// Clock zero: build our Tableau only.\n\t//\n");
+	if (sgn)
+		fprintf(fp, "\t// The sign bits of i_s and i_l are inverted where\n"
+			"\t// they meet the other operand, and the constant that\n"
+			"\t// makes up for it, out to NACC bits, is added to the\n"
+			"\t// first and last rows.\n"
+			"\t//\n");
+	tableaurows(rows, expr, premul, ns, nl, sgn, nacc, 0, false, 0);
+	buildstage(fp, rows, expr, 0, true, false, always_reset);
+	if (aux)
+		buildaux0(fp, always_reset);
+
+	clock = buildreduce(fp, rows, nacc, 0, pipe, aux, always_reset, 2);
+	assert(clock + 2 == nstages);
+
+	// i_clr, delayed to match the rows
+	fprintf(fp, "\n\t//\n\t// Clock %d: the accumulator\n\t//\n\n", clock+1);
+	fprintf(fp, "\treg\t[%d:0]\tr_clr;\n\n"
+		"\tinitial\tr_clr = 0;\n%s"
+		"\t\tr_clr <= 0;\n"
+		"\telse if (i_ce)\n", clock, always_reset.c_str());
+	if (clock > 0)
+		fprintf(fp, "\t\tr_clr <= { r_clr[%d:0], i_clr };\n\n", clock-1);
+	else
+		fprintf(fp, "\t\tr_clr <= i_clr;\n\n");
+
+	// The accumulator joins the last two rows as a third, and the three
+	// are compressed into two for the one adder
+	{
+		PPROW		acc, s, c;
+		std::string	sexpr, cexpr, sum;
+		std::vector<PPROW>	in;
+
+		acc.name = "M_acc";
+		acc.lsb = 0;
+		acc.width = nacc;
+		fprintf(fp, "\treg\t[%d:0]\tr_acc;\n"
+			"\twire\t[%d:0]\tM_acc;\n"
+			"\tassign\tM_acc = (r_clr[%d]) ? %d'b0 : r_acc;\n\n",
+			nacc-1, nacc-1, clock, nacc);
+
+		in.push_back(acc);
+		in.insert(in.end(), rows.begin(), rows.end());
+		if (in.size() == 3) {
+			s.name = "M_sum";
+			c.name = "M_carry";
+			if (csacompress(in, nacc, s, sexpr, c, cexpr)) {
+				fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+					"\tassign\t%s = %s;\n",
+					s.width-1, s.name.c_str(),
+					s.lsb+s.width-1, s.lsb,
+					s.name.c_str(), sexpr.c_str());
+				fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+					"\tassign\t%s = %s;\n\n",
+					c.width-1, c.name.c_str(),
+					c.lsb+c.width-1, c.lsb,
+					c.name.c_str(), cexpr.c_str());
+				in.clear();
+				in.push_back(s);
+				in.push_back(c);
+			}
+		}
+
+		for(unsigned k=0; k<in.size(); k++)
+			sum += ((k > 0) ? "\n\t\t\t+ " : "")
+				+ alignrow(in[k], 0, nacc);
+		fprintf(fp, "\tinitial\tr_acc = 0;\n%s"
+			"\t\tr_acc <= 0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tr_acc <= %s;\n\n", always_reset.c_str(), sum.c_str());
+	}
+
+	if (aux)
+		fprintf(fp, "\treg\tA_%d;\n"
+			"\tinitial\tA_%d = 0;\n%s"
+			"\t\tA_%d <= 1'b0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tA_%d <= A_%d;\n\n", clock+1, clock+1,
+			always_reset.c_str(), clock+1, clock+1, clock);
+
+	fprintf(fp, "\tassign\to_acc = r_acc;\n");
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock+1);
+
+	// The sum the accumulator should hold, from products found the
+	// simple way, and delayed along with i_clr
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp,
+	"\tlocalparam\tF_DELAY = %d;\n"
+	"\treg\t[F_DELAY*(NACC+1)-1:0]\tf_pipe;\n"
+	"\treg\t[NACC-1:0]\tf_acc;\n"
+	"\twire\t[NACC-1:0]\tf_result;\n\n", nstages-1);
+	if (sgn)
+		fprintf(fp, "\tassign\tf_result = i_a * i_b;\n\n");
+	else
+		fprintf(fp, "\tassign\tf_result = { {(NACC-NA){1\'b0}}, i_a }\n"
+			"\t\t\t* { {(NACC-NB){1\'b0}}, i_b };\n\n");
+	fprintf(fp,
+	"\tinitial\tf_pipe = 0;\n%s"
+		"\t\tf_pipe <= 0;\n"
+		"\telse if (i_ce)\n", always_reset.c_str());
+	if (nstages > 2)
+		fprintf(fp, "\t\tf_pipe <= { f_pipe[(F_DELAY-1)*(NACC+1)-1:0], i_clr, f_result };\n\n");
+	else
+		fprintf(fp, "\t\tf_pipe <= { i_clr, f_result };\n\n");
+	fprintf(fp,
+	"\tinitial\tf_acc = 0;\n%s"
+		"\t\tf_acc <= 0;\n"
+		"\telse if (i_ce)\n"
+		"\t\tf_acc <= ((f_pipe[F_DELAY*(NACC+1)-1]) ? 0 : f_acc)\n"
+		"\t\t\t+ f_pipe[(F_DELAY-1)*(NACC+1) +: NACC];\n\n"
+	"\talways @(*)\n"
+		"\t\tassert(o_acc == f_acc);\n\n", always_reset.c_str());
+	fprintf(fp, "`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildtruncmpy
+//
+// Writes a core giving only the top nout bits of the product: the unsigned
+// core's tableau (or, with sgn, its Baugh-Wooley rows), less every column too
+// far below o_p to matter by more than one bit of it, as truncation() finds.
+// What's left is added together just as buildumpy() would, but with shorter
+// rows, and so shorter carry chains.
+//
+void	buildtruncmpy(FILE *fp, const char *name, const int premul,
+		const int na, const int nb, const int nout, const bool sgn,
+		const bool aux, const bool async_reset) {
+	const int	ns = (na < nb) ? na : nb, nl = (na < nb) ? nb : na;
+	const int	np = na+nb, t = np-nout;
+	const int	nstages = truncstages(premul, na, nb, nout);
+	const PIPELINE	pipe = { nstages, nstages };
+	const TRUNC	tr = truncation(ns, nl, nout, sgn);
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	std::vector<PPROW>	rows;
+	std::vector<std::string>	expr;
+	int	clock;
+
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies two %s numbers together,\n"
+"//		keeping only the top %d bits of their %d-bit product, %s.\n"
+"//	The partial products below bit %d are never built, and a constant\n"
+"//	makes up for them, so that o_p, shifted up by %d bits, less the exact\n"
+"//	product (modulo 2^%d) is always within [%ld, %ld].  This file is\n"
+"//	computer generated, so please (for your sake) don\'t make any edits\n"
+"//	to this file lest you regenerate it and your edits be lost.\n"
+"//\n"
+"%s"
+"//\n", name, prjname, (sgn) ? "signed" : "unsigned", nout, np,
+		(round_flag) ? "rounded to the nearest" : "truncated",
+		tr.lo, t, np, tr.elo, tr.ehi, creator);
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d, NOUT=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb, nout,
+		rstname);
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t\t[(NOUT-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	buildbitadj(fp);
+
+	fprintf(fp, "\t// Clock zero: build what\'s left of our Tableau.\n\t//\n");
+	if ((tr.lo > 0)&&(varcomp_flag))
+		fprintf(fp, "\t// Columns [%d:0] are dropped, but for the bits of column\n"
+			"\t// %d, which are added in at twice their weight.\n\t//\n",
+			tr.lo-1, tr.lo-1);
+	else if (tr.lo > 0)
+		fprintf(fp, "\t// Columns [%d:0] are dropped.\n\t//\n", tr.lo-1);
+	if (sgn)
+		fprintf(fp, "\t// The sign bits of i_s and i_l are inverted where\n"
+			"\t// they meet the other operand, and the constant that\n"
+			"\t// makes up for it is added, along with the one for the\n"
+			"\t// dropped columns, to the first and last rows.\n"
+			"\t//\n");
+	tableaurows(rows, expr, premul, ns, nl, sgn, np, tr.lo, varcomp_flag,
+		tr.comp);
+	buildstage(fp, rows, expr, 0, true, false, always_reset);
+	if (aux)
+		buildaux0(fp, always_reset);
+
+	clock = buildreduce(fp, rows, np, 0, pipe, aux, always_reset, 1);
+	assert(clock + 1 == nstages);
+	assert(rows[0].lsb <= t);
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n",
+		alignrow(rows[0], t, nout).c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	// The columns kept below o_p only ever matter for their carries
+	if (rows[0].lsb < t)
+		fprintf(fp, "\n"
+		"\t// Make verilator happy\n"
+		"\t// verilator lint_off UNUSED\n"
+		"\twire\t[%d-1:0]\tunused_lsbs;\n"
+		"\tassign	unused_lsbs = %s[%d:0];\n"
+		"\t// verilator lint_on  UNUSED\n", t - rows[0].lsb,
+		rows[0].name.c_str(), t - rows[0].lsb - 1);
+
+	// The product, found the simple way, and delayed to match o_p
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp,
+	"\tlocalparam\tsigned [NA+NB-1:0]\tF_ELO = %s%d\'sd%ld,\n"
+	"\t\t\t\t\tF_EHI = %s%d\'sd%ld;\n"
+	"\twire\t[NA+NB-1:0]\tf_result, f_err;\n\n",
+		(tr.elo < 0) ? "-" : "", np, labs(tr.elo),
+		(tr.ehi < 0) ? "-" : "", np, labs(tr.ehi));
+	if (sgn)
+		fprintf(fp, "\tassign\tf_result = i_a * i_b;\n\n");
+	else
+		fprintf(fp, "\tassign\tf_result = { {(NB){1\'b0}}, i_a }\n"
+			"\t\t\t* { {(NA){1\'b0}}, i_b };\n\n");
+	buildfpipe(fp, nstages, "NA+NB", "f_result", always_reset);
+	if (t > 0)
+		fprintf(fp, "\tassign\tf_err = { o_p, %d\'b0 }", t);
+	else
+		fprintf(fp, "\tassign\tf_err = o_p");
+	fprintf(fp, " - f_pipe[F_DELAY*(NA+NB)-1 -: (NA+NB)];\n\n"
+	"\talways @(*)\n"
+	"\tif (f_valid[F_DELAY-1])\n"
+	"\tbegin\n"
+		"\t\tassert($signed(f_err) >= F_ELO);\n"
+		"\t\tassert($signed(f_err) <= F_EHI);\n"
+	"\tend\n\n");
+	fprintf(fp, "`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildsqr
+//
+// Writes a core squaring i_a, from the folded tableau sqrlevels() describes:
+// about half the partial products of an NxN multiply, and so about half the
+// rows.  Each level is written out as a wire, and each row of the tableau
+// adds premul of them together, save a last level on its own, whose bits
+// become rows of one bit that the adders pick up along the way.  With sgn,
+// the constant making up for the inverted bits is added into the first row.
+// The rows are then added together just as buildumpy() would.
+//
+void	buildsqr(FILE *fp, const char *name, const int premul, const int n,
+		const bool sgn, const bool aux, const bool async_reset) {
+	const int	np = 2*n;
+	const int	nstages = sqrstages(premul, n);
+	const PIPELINE	pipe = { nstages, nstages };
+	const std::vector<std::vector<std::string> >	levels
+				= sqrlevels(n, sgn);
+	const int	nlevels = levels.size();
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	std::vector<PPROW>	lrows, rows;
+	std::vector<std::string>	expr;
+	int	clock, nbits, nwide = sqrrows(premul, n, nbits);
+	char	str[64];
+
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file squares a %d-bit %s number.  Each\n"
+"//		product of two different bits of i_a is formed only once, at\n"
+"//	twice its weight, so the tableau holds %d rows where a %dx%d multiply\n"
+"//	would need %d.  This file is computer generated, so please (for your\n"
+"//	sake) don\'t make any edits to this file lest you regenerate it and\n"
+"//	your edits be lost.\n"
+"//\n"
+"%s"
+"//\n", name, prjname, n, (sgn) ? "signed" : "unsigned",
+		nwide + nbits, n, n, npremul(premul, n, n), creator);
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tN=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\t%s\t[(N-1):0]\ti_a;\n", n, rstname,
+		(sgn) ? "signed" : "");
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t\t[(2*N-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	// Each level, from the lowest column to the highest it holds
+	fprintf(fp, "\n\t// The folded tableau, one level at a time\n\t//\n");
+	if (sgn)
+		fprintf(fp, "\t// The products of the sign bit with the other bits\n"
+			"\t// of i_a are inverted, and the constant that makes up\n"
+			"\t// for it is added to the first row.\n"
+			"\t//\n");
+	for(int r=0; r<nlevels - ((nbits > 0) ? 1:0); r++) {
+		PPROW		l;
+		std::string	e;
+		int		lo = 0, hi = np-1, nterms = 0;
+
+		while(levels[r][lo].size() == 0)
+			lo++;
+		while(levels[r][hi].size() == 0)
+			hi--;
+
+		for(int c=hi; c>=lo; c--) {
+			if (nterms > 0)
+				e += ((nterms % 4) == 0) ? ",\n\t\t\t" : ", ";
+			e += (levels[r][c].size() > 0) ? levels[r][c] : "1\'b0";
+			nterms++;
+		}
+
+		sprintf(str, "L_%02d", r);
+		l.name = str;
+		l.lsb  = lo;
+		l.width = hi - lo + 1;
+		lrows.push_back(l);
+		if (l.width > 1)
+			fprintf(fp, "\twire\t[%d:0]\t%s;\t// Bits [%d:%d]\n"
+				"\tassign\t%s = { %s };\n", l.width-1, str,
+				hi, lo, str, e.c_str());
+		else
+			fprintf(fp, "\twire\t\t%s;\t// Bit %d\n"
+				"\tassign\t%s = %s;\n", str, lo, str,
+				e.c_str());
+	}
+
+	// Clock zero: premul levels to a row, any last level as single bits
+	fprintf(fp, "\n\t// Clock zero: add the levels together, %d at a time.\n\t//\n",
+		premul);
+	for(int k=0; k<nwide; k++) {
+		const int	nl = std::min(premul, nlevels - k*premul);
+		const PPROW	&base = lrows[k*premul];
+		std::string	e;
+		PPROW		r;
+
+		// Every level lies within the span of the one below it
+		r.lsb = base.lsb;
+		r.width = std::min(base.width + lg(nl), np - r.lsb);
+		if ((sgn)&&(k == 0))
+			r.width = np - r.lsb;
+		for(int j=0; j<nl; j++)
+			e += ((j > 0) ? "\n\t\t\t+ " : "")
+				+ alignrow(lrows[k*premul+j], r.lsb, r.width);
+		if ((sgn)&&(k == 0)) {
+			// Less 2^(2N-1) - 2^N, as 2^(2N-1) + 2^N
+			std::vector<bool>	cbits(r.width, false);
+
+			addbit(cbits, np-1 - r.lsb);
+			addbit(cbits, n - r.lsb);
+			e += "\n\t\t\t+ " + bitconst(cbits);
+		}
+
+		sprintf(str, "S_0_%02d", k);
+		r.name = str;
+		rows.push_back(r);
+		expr.push_back(e);
+	}
+	for(int c=0; (nbits > 0)&&(c<np); c++) {
+		PPROW	r;
+
+		if (levels[nlevels-1][c].size() == 0)
+			continue;
+		sprintf(str, "S_0_%02d", (int)rows.size());
+		r.name = str;
+		r.lsb = c;
+		r.width = 1;
+		rows.push_back(r);
+		expr.push_back(levels[nlevels-1][c]);
+	}
+	assert((int)rows.size() == nwide + nbits);
+
+	buildstage(fp, rows, expr, 0, true, false, always_reset);
+	if (aux)
+		buildaux0(fp, always_reset);
+
+	clock = buildreduce(fp, rows, np, 0, pipe, aux, always_reset, 1);
+	assert(clock + 1 == nstages);
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n",
+		alignrow(rows[0], 0, np).c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	// The square, found the simple way, and delayed to match o_p
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp, "\twire\t[2*N-1:0]\tf_result;\n\n");
+	if (sgn)
+		fprintf(fp, "\tassign\tf_result = i_a * i_a;\n\n");
+	else
+		fprintf(fp, "\tassign\tf_result = { {(N){1\'b0}}, i_a }\n"
+			"\t\t\t* { {(N){1\'b0}}, i_a };\n\n");
+	buildfpipe(fp, nstages, "2*N", "f_result", always_reset);
+	fprintf(fp,
+	"\talways @(*)\n"
+	"\tif (f_valid[F_DELAY-1])\n"
+		"\t\tassert(o_p == f_pipe[F_DELAY*(2*N)-1 -: (2*N)]);\n\n");
+	fprintf(fp, "`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildcmplx
+//
+// Writes a signed complex multiply, (i_ar + j i_ai) * (i_br + j i_bi), from
+// three of the signed cores rather than four, in the manner of Gauss:
+//
+//	K1 = i_br * (i_ar + i_ai)
+//	K2 = i_ar * (i_bi - i_br)
+//	K3 = i_ai * (i_br + i_bi)
+//
+// The real part of the product is then K1 - K3, and the imaginary part
+// K1 + K2.  The sums and difference of the operands are registered on clock
+// zero, and the two post-adders on the last clock.  Each sub-core is the
+// sgnmpy_XxY that buildmpy() writes, with the narrower operand first, as
+// buildsmpy() expects.  Should one size of sub-core take fewer clocks than
+// the other, its products are delayed to match.
+//
+void	buildcmplx(FILE *fp, const char *name, const int premul,
+		const int na, const int nb, const bool aux,
+		const bool async_reset) {
+	const int	np = na+nb+1, nstages = cmplxstages(premul, na, nb);
+	const PIPELINE	pipe = { nstages, nstages };
+	const int	lat[3] = { latency(premul, na+1, nb, true),
+				latency(premul, nb+1, na, true),
+				latency(premul, nb+1, na, true) },
+			wx[3] = { na+1, nb+1, nb+1 },
+			wy[3] = { nb, na, na };
+	const char	*opx[3] = { "u_sa", "u_db", "u_sb" },
+			*opy[3] = { "u_br", "u_ar", "u_ai" };
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	std::string	prod[3];
+	int		clock;
+	char		str[64];
+
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies two complex numbers together,\n"
+"//		each of two signed parts, from three real multiplies rather\n"
+"//	than four.  The sums feeding the multiplies, and the sums of their\n"
+"//	products, each take a clock of their own.  This file is computer\n"
+"//	generated, so please (for your sake) don\'t make any edits to this\n"
+"//	file lest you regenerate it and your edits be lost.\n"
+"//\n"
+"%s"
+"//\n", name, prjname, creator);
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_ar, i_ai, i_br, i_bi%s,\n"
+		"\t\to_pr, o_pi%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_ar, i_ai;\n"
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_br, i_bi;\n", na, nb,
+		rstname);
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\tsigned\t[(NA+NB):0]\to_pr, o_pi;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	fprintf(fp, "\n\t// Clock zero: the pre-adders, and the operands that\n"
+		"\t// meet their sums directly\n"
+		"\treg\t[(NA-1):0]\tu_ar, u_ai;\n"
+		"\treg\t[(NB-1):0]\tu_br;\n"
+		"\treg\t[NA:0]\t\tu_sa;\n"
+		"\treg\t[NB:0]\t\tu_db, u_sb;\n\n");
+	fprintf(fp, "\tinitial\t{ u_ar, u_ai, u_br, u_sa, u_db, u_sb } = 0;\n"
+		"%s\tbegin\n"
+		"\t\t{ u_ar, u_ai, u_br } <= 0;\n"
+		"\t\t{ u_sa, u_db, u_sb } <= 0;\n"
+		"\tend else if (i_ce)\n\tbegin\n"
+		"\t\tu_ar <= i_ar;\n"
+		"\t\tu_ai <= i_ai;\n"
+		"\t\tu_br <= i_br;\n"
+		"\t\tu_sa <= { i_ar[NA-1], i_ar } + { i_ai[NA-1], i_ai };\n"
+		"\t\tu_db <= { i_bi[NB-1], i_bi } - { i_br[NB-1], i_br };\n"
+		"\t\tu_sb <= { i_br[NB-1], i_br } + { i_bi[NB-1], i_bi };\n"
+		"\tend\n\n", always_reset.c_str());
+
+	clock = 0;
+	if (aux) {
+		buildaux0(fp, always_reset);
+
+		fprintf(fp, "\n\t// The sub-cores don\'t carry i_aux, so their o_aux\n"
+			"\t// outputs are left unused\n"
+			"\t// verilator lint_off UNUSED\n"
+			"\twire\t[2:0]\tw_aux;\n"
+			"\t// verilator lint_on  UNUSED\n");
+	}
+
+	fprintf(fp, "\n\t// Clocks one through %d: the three real products\n",
+		nstages-2);
+	for(int k=0; k<3; k++) {
+		const bool	swap = (wx[k] > wy[k]);
+
+		sprintf(str, "P_%d", k+1);
+		prod[k] = str;
+		fprintf(fp, "\twire\t[(NA+NB):0]\t%s;\n"
+			"\tsgnmpy_%dx%d\tk%d(i_clk, %s, i_ce, %s, %s,",
+			str, std::min(wx[k], wy[k]), std::max(wx[k], wy[k]),
+			k+1, rstname, (swap) ? opy[k] : opx[k],
+			(swap) ? opx[k] : opy[k]);
+		if (aux)
+			fprintf(fp, " 1\'b0, %s, w_aux[%d]);\n", str, k);
+		else
+			fprintf(fp, " %s);\n", str);
+	}
+
+	// Delay whichever products are ready early, along with i_aux
+	for(clock=1; clock<nstages-1; clock++) {
+		std::vector<PPROW>	rows;
+		std::vector<std::string>	expr;
+
+		for(int k=0; k<3; k++) {
+			PPROW	r;
+
+			if (lat[k] >= clock)
+				continue;
+			sprintf(str, "D_%d_%d", clock, k+1);
+			r.name = str;
+			r.lsb = 0;
+			r.width = np;
+			rows.push_back(r);
+			expr.push_back(prod[k]);
+			prod[k] = str;
+		}
+
+		if ((rows.size() > 0)||(aux)) {
+			fprintf(fp, "\n");
+			buildstage(fp, rows, expr, clock, regstage(pipe, clock),
+				aux, always_reset);
+		}
+	}
+
+	// The post-adders
+	{
+		std::vector<PPROW>	rows(2);
+		std::vector<std::string>	expr(2);
+
+		fprintf(fp, "\n\t//\n\t// Clock %d: the real part is K1 - K3, and the\n"
+			"\t// imaginary part K1 + K2\n\t//\n\n", clock);
+		for(int k=0; k<2; k++) {
+			sprintf(str, "S_%d_%02d", clock, k);
+			rows[k].name = str;
+			rows[k].lsb = 0;
+			rows[k].width = np;
+		}
+		expr[0] = prod[0] + " - " + prod[2];
+		expr[1] = prod[0] + " + " + prod[1];
+		buildstage(fp, rows, expr, clock, regstage(pipe, clock), aux,
+			always_reset);
+
+		fprintf(fp, "\n\tassign\to_pr = %s;\n"
+			"\tassign\to_pi = %s;\n",
+			rows[0].name.c_str(), rows[1].name.c_str());
+		if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+	}
+
+	// The product, found the simple way, and delayed to match
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp,
+	"\twire\tsigned\t[NA+NB:0]\tf_pr, f_pi;\n\n"
+	"\tassign\tf_pr = i_ar * i_br - i_ai * i_bi;\n"
+	"\tassign\tf_pi = i_ar * i_bi + i_ai * i_br;\n\n");
+	buildfpipe(fp, nstages, "2*(NA+NB+1)", "{ f_pr, f_pi }",
+		always_reset);
+	fprintf(fp,
+	"\talways @(*)\n"
+	"\tif (f_valid[F_DELAY-1])\n"
+		"\t\tassert({ o_pr, o_pi } == f_pipe[F_DELAY*2*(NA+NB+1)-1 -: 2*(NA+NB+1)]);\n\n");
+	fprintf(fp, "`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildsimd
+//
+// Writes an unsigned NxN multiply whose operands may instead hold packed
+// lanes, as i_mode picks: one lane of N bits for a mode of zero, two of N/2
+// for one, and so on down to lanes of lane bits, which any larger mode also
+// picks.  Each bit of i_a only meets the bits of i_b within its own lane, so
+// the partial products between lanes are gated off as the tableau is built,
+// and the product of every lane lands in its own 2x wider slice of o_p.  No
+// lane's product can carry into the next, so the rows are otherwise added
+// together just as buildumpy() would.  i_mode only matters on clock zero, and
+// so may change along with the operands.
+//
+void	buildsimd(FILE *fp, const char *name, const int premul, const int n,
+		const int lane, const bool aux, const bool async_reset) {
+	const int	np = 2*n, nblocks = n / lane,
+			nmodes = simdmodes(n, lane), mbits = lg(nmodes);
+	const int	nstages = simdstages(premul, n);
+	const PIPELINE	pipe = { nstages, nstages };
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	std::vector<PPROW>	rows;
+	std::vector<std::string>	expr;
+	int	clock;
+	char	str[64];
+
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies two unsigned %d-bit numbers\n"
+"//		together or, as i_mode picks, from %d to %d packed lanes of\n"
+"//	%d to %d bits within them, each lane by the same lane of the other.\n"
+"//	Partial products between lanes are gated off within the tableau, so\n"
+"//	every lane's product lands in its own slice of o_p.  This file is\n"
+"//	computer generated, so please (for your sake) don\'t make any edits\n"
+"//	to this file lest you regenerate it and your edits be lost.\n"
+"//\n"
+"%s"
+"//\n", name, prjname, n, 2, nblocks, n/2, lane, creator);
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_mode, i_a, i_b%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tN=%d, LANE=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\t// Lanes of N bits for zero, N/2 for one, and so on\n"
+		"\tinput\t\t\t[%d:0]\t\ti_mode;\n"
+		"\tinput\t\t\t[(N-1):0]\ti_a, i_b;\n", n, lane, rstname,
+		mbits-1);
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t\t[(2*N-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	// E_d: two blocks of lane bits, whose numbers first differ in bit
+	// d-1, lie within the same lane
+	fprintf(fp, "\n\t// E_d is set when LANE-bit blocks whose numbers differ\n"
+		"\t// first in bit d-1 lie within the same lane\n\t//\n");
+	for(int d=1; d<nmodes; d++)
+		fprintf(fp, "\twire\tE_%d;\n"
+			"\tassign\tE_%d = (i_mode <= %d\'d%d);\n",
+			d, d, mbits, nmodes-1-d);
+
+	// B_k: i_b, less the bits outside of the lane of block k of i_a
+	fprintf(fp, "\n\t// B_k is i_b, less every bit outside of the lane of\n"
+		"\t// block k of i_a\n\t//\n");
+	for(int bi=0; bi<nblocks; bi++) {
+		std::string	e;
+
+		for(int bj=nblocks-1; bj>=0; bj--) {
+			const int	d = (bi == bj) ? 0 : lg((bi ^ bj)+1);
+
+			if (d == 0)
+				sprintf(str, "{(%d){1\'b1}}", lane);
+			else
+				sprintf(str, "{(%d){E_%d}}", lane, d);
+			if (bj < nblocks-1)
+				e += ((nblocks-1-bj) % 4 == 0) ? ",\n\t\t\t" : ", ";
+			e += str;
+		}
+		fprintf(fp, "\twire\t[(N-1):0]\tB_%02d;\n"
+			"\tassign\tB_%02d = i_b & { %s };\n", bi, bi, e.c_str());
+	}
+
+	// Clock zero: premul bits of i_a to a row, each with the B_k of its
+	// own block
+	fprintf(fp, "\n\t// Clock zero: build the gated tableau, %d bits of i_a to\n"
+		"\t// a row.\n\t//\n", premul);
+	for(int lsb=0; lsb<n; lsb+=premul) {
+		const int	nk = std::min(premul, n-lsb);
+		std::string	e;
+		PPROW		r;
+
+		r.lsb = lsb;
+		r.width = n + nk;
+		for(int k=0; k<nk; k++) {
+			const int	b = lsb+k;
+
+			if (k > 0)
+				e += "\n\t\t\t+ ";
+			e += "{ ";
+			if (r.width - n - k > 0) {
+				sprintf(str, "%d\'b0, ", r.width - n - k);
+				e += str;
+			}
+			sprintf(str, "((i_a[%d]) ? B_%02d : %d\'b0)", b,
+				b / lane, n);
+			e += str;
+			if (k > 0) {
+				sprintf(str, ", %d\'b0", k);
+				e += str;
+			}
+			e += " }";
+		}
+
+		sprintf(str, "S_0_%02d", (int)rows.size());
+		r.name = str;
+		rows.push_back(r);
+		expr.push_back(e);
+	}
+	assert((int)rows.size() == npremul(premul, n, n));
+
+	buildstage(fp, rows, expr, 0, true, false, always_reset);
+	if (aux)
+		buildaux0(fp, always_reset);
+
+	clock = buildreduce(fp, rows, np, 0, pipe, aux, always_reset, 1);
+	assert(clock + 1 == nstages);
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n",
+		alignrow(rows[0], 0, np).c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	// Every lane's product, found the simple way, and delayed to match o_p
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp, "\treg\t[2*N-1:0]\tf_result;\n\n");
+	fprintf(fp, "\talways @(*)\n\tcase(i_mode)\n");
+	for(int m=0; m<nmodes; m++) {
+		const int	w = n >> m;
+
+		if (m < nmodes-1)
+			fprintf(fp, "\t%d\'d%d: f_result = {", mbits, m);
+		else
+			fprintf(fp, "\tdefault: f_result = {");
+		for(int k=(1<<m)-1; k>=0; k--)
+			fprintf(fp, "%s({ %d\'b0, i_a[%d:%d] } * { %d\'b0, i_b[%d:%d] })",
+				(k < (1<<m)-1) ? ",\n\t\t\t" : " ",
+				w, (k+1)*w-1, k*w, w, (k+1)*w-1, k*w);
+		fprintf(fp, " };\n");
+	}
+	fprintf(fp, "\tendcase\n\n");
+	buildfpipe(fp, nstages, "2*N", "f_result", always_reset);
+	fprintf(fp,
+	"\talways @(*)\n"
+	"\tif (f_valid[F_DELAY-1])\n"
+		"\t\tassert(o_p == f_pipe[F_DELAY*(2*N)-1 -: (2*N)]);\n\n");
+	fprintf(fp, "`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// builddot
+//
+// Writes a core adding n products together, of i_a[k*NA +: NA] by
+// i_b[k*NB +: NB] for each k, signed or not.  Rather than a multiply for each
+// product, each with an adder tree of its own and a carry chain at its end,
+// and then another tree adding the products together, the rows of every
+// product's tableau are added together in the one tree, with the one carry
+// chain at its end.  The rows are those tableaurows() builds for the unsigned
+// core, or for the Baugh-Wooley signed core, sign corrected out to the width
+// of the sum.
+//
+void	builddot(FILE *fp, const char *name, const int premul, const int n,
+		const int na, const int nb, const bool sgn, const bool aux,
+		const bool async_reset) {
+	const int	ns = (na < nb) ? na : nb, nl = (na < nb) ? nb : na,
+			np = dotbits(n, na, nb);
+	const int	nstages = dotstages(premul, n, na, nb);
+	const PIPELINE	pipe = { nstages, nstages };
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	std::vector<PPROW>	rows;
+	std::vector<std::string>	expr;
+	int	clock;
+	char	str[64];
+
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file adds %d products of %s numbers\n"
+"//		together, each of NA bits of i_a by the same NB bits of i_b.\n"
+"//	The %d rows of all of their tableaus are added together in the one\n"
+"//	tree, with one carry chain at its end.  This file is computer\n"
+"//	generated, so please (for your sake) don\'t make any edits to this\n"
+"//	file lest you regenerate it and your edits be lost.\n"
+"//\n"
+"%s"
+"//\n", name, prjname, n, (sgn) ? "signed" : "unsigned",
+		n * npremul(premul, na, nb), creator);
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tN=%d, NA=%d, NB=%d;\n"
+		"\tlocalparam\tNP=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\t\t[(N*NA-1):0]\ti_a;\n"
+		"\tinput\t\t\t[(N*NB-1):0]\ti_b;\n", n, na, nb, np,
+		rstname);
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t\t[(NP-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	// The operands of each product, the smaller first
+	fprintf(fp, "\n\t// The operands of each product: s_k, the one with the\n"
+		"\t// fewest bits, and l_k, the one with the most\n\t//\n");
+	for(int k=0; k<n; k++) {
+		fprintf(fp, "\twire\t[%d:0]\ts_%02d;\n"
+			"\twire\t[%d:0]\tl_%02d;\n", ns-1, k, nl-1, k);
+		fprintf(fp, "\tassign\ts_%02d = %s[%d:%d];\n"
+			"\tassign\tl_%02d = %s[%d:%d];\n",
+			k, (na < nb) ? "i_a" : "i_b", (k+1)*ns-1, k*ns,
+			k, (na < nb) ? "i_b" : "i_a", (k+1)*nl-1, k*nl);
+	}
+
+	fprintf(fp, "\n\t// Clock zero: the tableau of every product.\n\t//\n");
+	if (sgn)
+		fprintf(fp, "\t// The sign bits of s_k and l_k are inverted where\n"
+			"\t// they meet the other operand, and the constant that\n"
+			"\t// makes up for it, out to NP bits, is added to the\n"
+			"\t// first and last rows of each.\n"
+			"\t//\n");
+	for(int k=0; k<n; k++) {
+		std::vector<PPROW>	prows;
+		std::vector<std::string>	pexpr;
+		std::string	sname, lname;
+
+		// tableaurows() writes its rows in terms of i_s and i_l, of
+		// which each product has its own
+		sprintf(str, "s_%02d[", k);
+		sname = str;
+		sprintf(str, "l_%02d", k);
+		lname = str;
+		tableaurows(prows, pexpr, premul, ns, nl, sgn, np, 0, false, 0);
+		for(unsigned r=0; r<prows.size(); r++) {
+			std::string	&e = pexpr[r];
+			size_t		pos;
+
+			while((pos = e.find("i_s[")) != std::string::npos)
+				e.replace(pos, 4, sname);
+			while((pos = e.find("i_l")) != std::string::npos)
+				e.replace(pos, 3, lname);
+
+			sprintf(str, "S_0_%02d", (int)rows.size());
+			prows[r].name = str;
+			rows.push_back(prows[r]);
+			expr.push_back(e);
+		}
+	}
+	assert((int)rows.size() == n * npremul(premul, na, nb));
+
+	buildstage(fp, rows, expr, 0, true, false, always_reset);
+	if (aux)
+		buildaux0(fp, always_reset);
+
+	clock = buildreduce(fp, rows, np, 0, pipe, aux, always_reset, 1);
+	assert(clock + 1 == nstages);
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n",
+		alignrow(rows[0], 0, np).c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	// The sum, found the simple way, and delayed to match o_p
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp, "\twire\t[NP-1:0]\tf_result;\n\n");
+	fprintf(fp, "\tassign\tf_result = ");
+	for(int k=0; k<n; k++) {
+		if (k > 0)
+			fprintf(fp, "\n\t\t\t+ ");
+		if (sgn)
+			fprintf(fp, "$signed(i_a[%d*NA +: NA]) * $signed(i_b[%d*NB +: NB])",
+				k, k);
+		else
+			fprintf(fp, "i_a[%d*NA +: NA] * i_b[%d*NB +: NB]", k, k);
+	}
+	fprintf(fp, ";\n\n");
+	buildfpipe(fp, nstages, "NP", "f_result", always_reset);
+	fprintf(fp,
+	"\talways @(*)\n"
+	"\tif (f_valid[F_DELAY-1])\n"
+		"\t\tassert(o_p == f_pipe[F_DELAY*NP-1 -: NP]);\n\n");
+	fprintf(fp, "`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildboothmpy
+//
+// Writes a signed multiply with the same ports, and the same o_aux timing,
+// as the one buildsmpy() writes, but one that never needs to negate either
+// operand or the product.  Instead, the smaller operand is recoded into
+// radix-4 Booth digits, each from -2 to 2, and each digit selects a row of
+// 0, +/-1, or +/-2 times the larger operand.  Negative rows are only
+// inverted, with the one that completes each negation added in by the row
+// below it, and every row's sign extension is replaced by a few constant
+// ones, so that the rows can then simply be added together.
+//
+void	buildboothmpy(FILE *fp, const char *name, const int na, const int nb,
+		const bool aux, const bool async_reset) {
+	const int	ns = (na < nb) ? na : nb, nl = (na < nb) ? nb : na,
+			np = na+nb, nrows = boothrows(na, nb);
+	const PIPELINE	pipe = { boothstages(na, nb),
+				latency(2, na, nb, true) };
+	std::vector<PPROW>	rows;
+	int	clock;
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies two signed numbers together,\n"
+"//		without using any hardware acceleration, from radix-4 Booth\n"
+"//\tencoded partial products.  This file is computer generated, so please\n"
+"//\t(for your sake) don\'t make any edits to this file lest you regenerate\n"
+"//\tit and your edits be lost.\n"
+"//\n"
+"//\n%s"
+"//\n", name, prjname, creator);
+
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
+		name, (async_reset)?"i_areset_n":"i_reset",
+		(aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n"
+		"\tinput\t\tsigned\t[(NB-1):0]\ti_b;\n", na, nb,
+		(async_reset)?"i_areset_n":"i_reset");
+
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\tsigned\t[(NA+NB-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	buildbitadj(fp);
+
+	clock = 0;
+	fprintf(fp, "\t// Clock zero: recode i_s into Booth digits, three bits at a\n"
+		"\t// time, overlapping by one, and use each digit to select 0,\n"
+		"\t// +/-1, or +/-2 times i_l.  Negative multiples are only inverted\n"
+		"\t// here.  The one needed to finish negating each is kept in N_0.\n"
+		"\t//\n");
+	fprintf(fp, "\twire\t[NL:0]\tw_x1, w_x2;\n"
+		"\tassign\tw_x1 = { i_l[NL-1], i_l };\n"
+		"\tassign\tw_x2 = { i_l, 1\'b0 };\n\n");
+
+	for(int row=0; row<nrows; row++) {
+		int	bit[3];
+
+		// Digits above the top of i_s see copies of its sign bit
+		for(int k=0; k<3; k++) {
+			bit[k] = 2*row+1-k;
+			if (bit[k] > ns-1)
+				bit[k] = ns-1;
+		}
+
+		fprintf(fp, "\twire\t[2:0]\tD_%02d;\n", row);
+		if (row == 0)
+			fprintf(fp, "\tassign\tD_%02d = { i_s[%d], i_s[%d], 1\'b0 };\n",
+				row, bit[0], bit[1]);
+		else
+			fprintf(fp, "\tassign\tD_%02d = { i_s[%d], i_s[%d], i_s[%d] };\n",
+				row, bit[0], bit[1], bit[2]);
+	}
+
+	fprintf(fp, "\n");
+	if (!regstage(pipe, 0)) {
+		for(int row=0; row<nrows; row++)
+			fprintf(fp, "\twire\t[%d:0]\tB_0_%02d;\n"
+			"\tassign\tB_0_%02d = ((D_%02d[1] ^ D_%02d[0]) ? w_x1\n"
+			"\t\t\t: ((D_%02d == 3\'b011)||(D_%02d == 3\'b100)) ? w_x2\n"
+			"\t\t\t: {(NL+1){1\'b0}}) ^ {(NL+1){D_%02d[2]}};\n",
+				nl, row, row, row, row, row, row, row);
+		fprintf(fp, "\twire\t[%d:0]\tN_0;\n"
+			"\tassign\tN_0 = { ", nrows-1);
+		for(int row=nrows-1; row>=0; row--)
+			fprintf(fp, "D_%02d[2]%s", row, (row > 0) ? ", ":" };\n");
+		if (aux)
+			fprintf(fp, "\twire\tA_%d;\n"
+				"\tassign\tA_%d = i_aux;\n", clock, clock);
+	} else {
+		for(int row=0; row<nrows; row++)
+			fprintf(fp, "\treg\t[%d:0]\tB_0_%02d;\n", nl, row);
+		fprintf(fp, "\treg\t[%d:0]\tN_0;\n", nrows-1);
+		if (aux) fprintf(fp, "\treg\tA_%d;\n", clock);
+
+		fprintf(fp, "\n");
+		for(int row=0; row<nrows; row++)
+			fprintf(fp, "\tinitial\tB_0_%02d = 0;\n", row);
+		fprintf(fp, "\tinitial\tN_0 = 0;\n");
+		fprintf(fp, "%s\tbegin\n", always_reset.c_str());
+		for(int row=0; row<nrows; row++)
+			fprintf(fp, "\t\tB_0_%02d <= 0;\n", row);
+		fprintf(fp, "\t\tN_0 <= 0;\n"
+			"\tend else if (i_ce)\n\tbegin\n");
+		for(int row=0; row<nrows; row++)
+			fprintf(fp, "\t\tB_0_%02d <= ((D_%02d[1] ^ D_%02d[0]) ? w_x1\n"
+			"\t\t\t: ((D_%02d == 3\'b011)||(D_%02d == 3\'b100)) ? w_x2\n"
+			"\t\t\t: {(NL+1){1\'b0}}) ^ {(NL+1){D_%02d[2]}};\n",
+				row, row, row, row, row, row);
+		fprintf(fp, "\t\tN_0 <= { ");
+		for(int row=nrows-1; row>=0; row--)
+			fprintf(fp, "D_%02d[2]%s", row, (row > 0) ? ", ":" };\n");
+		fprintf(fp, "\tend\n");
+
+		if (aux)
+			fprintf(fp, "\n\tinitial\tA_%d = 0;\n%s"
+			"\t\tA_%d <= 1'b0;\n"
+			"\telse if (i_ce)\n"
+			"\t\tA_%d <= i_aux;\n", clock,
+			always_reset.c_str(), clock, clock);
+	}
+
+	fprintf(fp, "\n"
+		"\t// Rather than sign extending each row, row zero starts with\n"
+		"\t// { ~s, s, s } and every other row with { 1, ~s }.  Each row past\n"
+		"\t// the first also finishes negating the row before it.\n"
+		"\t//\n");
+	for(int row=0; row<nrows; row++) {
+		std::vector<std::string>	field;
+		char	str[64];
+		PPROW	r;
+		int	width;
+
+		// The fields of each row, from its LSB up, one bit each but
+		// for the row itself
+		r.lsb = (row == 0) ? 0 : 2*row-2;
+		if (row > 0) {
+			sprintf(str, "N_0[%d]", row-1);
+			field.push_back(str);
+			field.push_back("1\'b0");
+		}
+		sprintf(str, "B_0_%02d[%d:0]", row, nl-1);
+		field.push_back(str);
+		if (row == 0) {
+			sprintf(str, "B_0_%02d[%d]", row, nl);
+			field.push_back(str);
+			field.push_back(str);
+			sprintf(str, "~B_0_%02d[%d]", row, nl);
+			field.push_back(str);
+		} else {
+			sprintf(str, "~B_0_%02d[%d]", row, nl);
+			field.push_back(str);
+			field.push_back("1\'b1");
+		}
+
+		// Anything above the product is dropped.  That's never more
+		// than the constants at the top of the row.
+		width = (row == 0) ? nl+3 : nl+4;
+		while(r.lsb + width > np) {
+			assert(field.size() > ((row == 0) ? 2u : 4u));
+			field.pop_back();
+			width--;
+		}
+		sprintf(str, "S_0_%02d", row);
+		r.name = str;
+		r.width = width;
+		rows.push_back(r);
+
+		fprintf(fp, "\twire\t[%d:0]\t%s;\n", width-1, str);
+		fprintf(fp, "\tassign\t%s = { ", str);
+		for(int k=field.size()-1; k>=0; k--)
+			fprintf(fp, "%s%s", field[k].c_str(), (k > 0) ? ", ":" };\n");
+	}
+
+	// The last row is the only one left to finish negating
+	{
+		char	str[64];
+		PPROW	r;
+
+		sprintf(str, "N_0[%d]", nrows-1);
+		r.name = str;
+		r.lsb = 2*nrows-2;
+		r.width = 1;
+		rows.push_back(r);
+	}
+
+	clock = buildreduce(fp, rows, np, clock, pipe, aux, always_reset, 1);
+
+	// The core descriptions depend upon this
+	assert(clock + 1 == pipe.nstages);
+	assert((rows[0].lsb == 0)&&(rows[0].width == np));
+
+	fprintf(fp, "\n\tassign\to_p = %s;\n", rows[0].name.c_str());
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clock);
+
+	buildformal(fp, pipe, aux, async_reset, true);
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// buildbsmpy
+//
+// Writes a bit-sliced C++ model of the same netlist buildumpy() and
+// buildsmpy() generate.  Every signal becomes an array of words, one word
+// per bit, and each bit within a word belongs to a separate test vector.
+// The word type, W, is a template parameter: a uint64_t gives 64 products
+// per evaluation, while a GCC vector type (such as a vector_size(32)
+// uint64_t) gives 256 or 512.
+//
+// The pipeline registers are left out.  Only the arithmetic is modeled,
+// row for row and round for round as the Verilog builds it, with every
+// intermediate truncated to the width the Verilog gives it.
+//
+void	buildbsmpy(FILE *fp, const char *name, const int premul,
+		const int na, const int nb) {
+	int	row, clock, nbits, nrows, nzros, maxbits = na+nb, sz;
+	int	ns, nl;
+	ns = (na < nb) ? na : nb;
+	nl = (na < nb) ? nb : na;
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.h\n"
+"//\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:	A bit-sliced C++ model of the umpy_%dx%d and sgnmpy_%dx%d\n"
+"//		cores.  Each bit of the word type W is an independent test\n"
+"//	vector.  Pipeline registers are not modeled, just the arithmetic of\n"
+"//	each stage.  This file is computer generated, so please don\'t edit\n"
+"//	it.\n"
+"//\n"
+"%s"
+"//\n"
+"%s",
+		name, prjname, na, nb, na, nb, creator, cpyleft);
+
+	fprintf(fp, "#ifndef\tBSMPY_%dx%d_H\n#define\tBSMPY_%dx%d_H\n\n",
+		na, nb, na, nb);
+
+	// The helpers are the same for every size, so they may only be
+	// defined once
+	fprintf(fp,
+"#ifndef\tBSMPY_HELPERS\n"
+"#define\tBSMPY_HELPERS\n"
+"\n"
+"// r[0..rn-1] = (x << xsh) + (y << ysh), for x and y of xn and yn bits\n"
+"template<class W> static inline void bs_add(W *r, const int rn,\n"
+"\t\tconst W *x, const int xn, const int xsh,\n"
+"\t\tconst W *y, const int yn, const int ysh) {\n"
+"\tW\tc = W{};\n"
+"\n"
+"\tfor(int k=0; k<rn; k++) {\n"
+"\t\tW\txb = ((k >= xsh)&&(k-xsh < xn)) ? x[k-xsh] : W{};\n"
+"\t\tW\tyb = ((k >= ysh)&&(k-ysh < yn)) ? y[k-ysh] : W{};\n"
+"\t\tW\th  = xb ^ yb;\n"
+"\n"
+"\t\tr[k] = h ^ c;\n"
+"\t\tc = (xb & yb) | (h & c);\n"
+"\t}\n"
+"}\n"
+"\n"
+"// r[0..n-1] = (s) ? -x : x\n"
+"template<class W> static inline void bs_cneg(W *r, const W *x, const int n,\n"
+"\t\tconst W &s) {\n"
+"\tW\tc = s;\n"
+"\n"
+"\tfor(int k=0; k<n; k++) {\n"
+"\t\tW\txb = x[k] ^ s;\n"
+"\n"
+"\t\tr[k] = xb ^ c;\n"
+"\t\tc = xb & c;\n"
+"\t}\n"
+"}\n"
+"\n"
+"// The bimpy 2xBW multiply: r[0..BW+1] = a[1:0] * b[BW-1:0]\n"
+"template<class W, int BW> static inline void bs_bimpy(W *r, const W *a,\n"
+"\t\tconst W *b) {\n"
+"\tW\tw[BW+1], c[BW+1];\n"
+"\n"
+"\t// w_r =  { i_a[1] ? i_b : 0, 1'b0 } ^ { 1'b0, i_a[0] ? i_b : 0 }\n"
+"\t// c   = (i_a[1] ? i_b[BW-2:0] : 0) & (i_a[0] ? i_b[BW-1:1] : 0)\n"
+"\tfor(int k=0; k<=BW; k++) {\n"
+"\t\tW\thi = (k >= 1) ? (a[1] & b[k-1]) : W{};\n"
+"\t\tW\tlo = (k < BW) ? (a[0] & b[k])   : W{};\n"
+"\n"
+"\t\tw[k] = hi ^ lo;\n"
+"\t\tc[k] = hi & lo;\n"
+"\t}\n"
+"\n"
+"\t// o_r <= w_r + { c, 2'b0 }, where c[k] is the carry out of bit k\n"
+"\tbs_add(r, BW+2, w, BW+1, 0, c, BW+1, 1);\n"
+"}\n"
+"\n"
+"// The premulN NxBW multiply: r[0..BW+N-1] = a[N-1:0] * b[BW-1:0]\n"
+"template<class W, int N, int BW> static inline void bs_premul(W *r,\n"
+"\t\tconst W *a, const W *b) {\n"
+"\tW\tacc[BW+N], row[BW], nxt[BW+N];\n"
+"\n"
+"\tfor(int k=0; k<BW+N; k++)\n"
+"\t\tacc[k] = W{};\n"
+"\tfor(int j=0; j<N; j++) {\n"
+"\t\tfor(int k=0; k<BW; k++)\n"
+"\t\t\trow[k] = a[j] & b[k];\n"
+"\t\tbs_add(nxt, BW+N, acc, BW+N, 0, row, BW, j);\n"
+"\t\tfor(int k=0; k<BW+N; k++)\n"
+"\t\t\tacc[k] = nxt[k];\n"
+"\t}\n"
+"\n"
+"\tfor(int k=0; k<BW+N; k++)\n"
+"\t\tr[k] = acc[k];\n"
+"}\n"
+"#endif\t// BSMPY_HELPERS\n\n");
+
+	//
+	// The unsigned multiply
+	//
+	fprintf(fp,
+"//\n"
+"// bsumpy_%dx%d\n"
+"//\n"
+"// o_p[0..%d] = i_a[0..%d] * i_b[0..%d], unsigned\n"
+"//\n"
+"template<class W> void	bsumpy_%dx%d(W *o_p, const W *i_a, const W *i_b) {\n",
+		na, nb, na+nb-1, na-1, nb-1, na, nb);
+	fprintf(fp, "\tconst W\t*i_s = i_%c, *i_l = i_%c;\n",
+		(na < nb) ? 'a' : 'b', (na < nb) ? 'b' : 'a');
+
+	// Clock zero: the tableau
+	clock = 0;
+	fprintf(fp, "\n\t// Clock zero: the tableau\n");
+	for(row=0; row<ns/premul; row++) {
+		fprintf(fp, "\tW\tS_0_%02d[%d];\n", row, nl+premul);
+		if (premul == 2)
+			fprintf(fp, "\tbs_bimpy<W,%d>(S_0_%02d, i_s+%d, i_l);\n",
+				nl, row, row*premul);
+		else
+			fprintf(fp, "\tbs_premul<W,%d,%d>(S_0_%02d, i_s+%d, i_l);\n",
+				premul, nl, row, row*premul);
+	}
+	if (ns%premul) {
+		// The extra row gets zeros above the last bit of i_s
+		fprintf(fp, "\tW\tS_0_%02d[%d], x_s[%d];\n", row, nl+premul,
+			premul);
+		fprintf(fp, "\tfor(int k=0; k<%d; k++)\n"
+			"\t\tx_s[k] = (k < %d) ? i_s[%d+k] : W{};\n",
+			premul, ns - row*premul, row*premul);
+		if (premul == 2)
+			fprintf(fp, "\tbs_bimpy<W,%d>(S_0_%02d, x_s, i_l);\n",
+				nl, row);
+		else
+			fprintf(fp, "\tbs_premul<W,%d,%d>(S_0_%02d, x_s, i_l);\n",
+				premul, nl, row);
+	}
+	sz = nl+premul;
+
+	nrows = (ns/premul)+((ns%premul)?1:0); nbits = nl+premul, nzros=premul;
+	while(nrows > 1) {
+		int	lastsz = sz;
+
+		clock++;
+		sz = ((nbits+1+nzros)>maxbits)?maxbits :(nbits+1+nzros);
+		fprintf(fp, "\n\t// Round #%d\n", clock);
+		for(row=0; row<nrows/2; row++) {
+			fprintf(fp, "\tW\tS_%d_%02d[%d];\n", clock, row, sz);
+			fprintf(fp, "\tbs_add(S_%d_%02d, %d, S_%d_%02d, %d, 0, S_%d_%02d, %d, %d);\n",
+				clock, row, sz,
+				clock-1, 2*row, lastsz,
+				clock-1, 2*row+1, lastsz, nzros);
+		}
+		if (nrows&1) {
+			fprintf(fp, "\tW\tS_%d_%02d[%d];\n", clock, row, sz);
+			fprintf(fp, "\tfor(int k=0; k<%d; k++)\n"
+				"\t\tS_%d_%02d[k] = (k < %d) ? S_%d_%02d[k] : W{};\n",
+				sz, clock, row, lastsz, clock-1, nrows-1);
+		}
+
+		nrows = (nrows+1)/2;
+		nbits+=1+nzros; nzros<<= 1;
+	}
+
+	fprintf(fp, "\n\tfor(int k=0; k<%d; k++)\n"
+		"\t\to_p[k] = (k < %d) ? S_%d_00[k] : W{};\n}\n\n",
+		maxbits, sz, clock);
+
+	//
+	// The signed multiply
+	//
+	fprintf(fp,
+"//\n"
+"// bssgnmpy_%dx%d\n"
+"//\n"
+"// o_p[0..%d] = i_a[0..%d] * i_b[0..%d], signed.  As with sgnmpy_%dx%d, the\n"
+"// magnitudes are multiplied, and the result negated if need be.\n"
+"//\n"
+"template<class W> void	bssgnmpy_%dx%d(W *o_p, const W *i_a, const W *i_b) {\n"
+"\tW\tu_a[%d], u_b[%d], u_r[%d];\n"
+"\n"
+"\tbs_cneg(u_a, i_a, %d, i_a[%d]);\n"
+"\tbs_cneg(u_b, i_b, %d, i_b[%d]);\n"
+"\tbsumpy_%dx%d(u_r, u_a, u_b);\n"
+"\tbs_cneg(o_p, u_r, %d, i_a[%d] ^ i_b[%d]);\n"
+"}\n\n",
+		na, nb, na+nb-1, na-1, nb-1, na, nb,
+		na, nb, na, nb, na+nb,
+		na, na-1, nb, nb-1, na, nb, na+nb, na-1, nb-1);
+
+	fprintf(fp, "#endif\t// BSMPY_%dx%d_H\n", na, nb);
+}
+
+//
+// vltype
+//
+// The type Verilator uses for a port of the given width, so that the C++
+// models below can be dropped in wherever the Verilated ones were
+//
+const char	*vltype(const int w) {
+	if (w <= 8)
+		return "uint8_t ";
+	else if (w <= 16)
+		return "uint16_t";
+	else if (w <= 32)
+		return "uint32_t";
+	return "uint64_t";
+}
+
+//
+// buildcmpy
+//
+// Writes a cycle-accurate C++ model of either the umpy or the sgnmpy core,
+// with the same ports as the Verilated model.  Since every register in
+// either core is cleared by the same reset and advanced by the same i_ce,
+// the whole core is just a delay line from the product of i_a and i_b to
+// o_p--so that's all this models, using the native multiply.  The widths
+// must fit in 64-bits for that.
+//
+void	buildcmpy(FILE *fp, const char *name, const int premul,
+		const int na, const int nb, const bool sgn,
+		const bool aux, const bool async_reset) {
+	const int	delay = latency(premul, na, nb, sgn);
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	unsigned long	pmask;
+	std::string	guard = name;
+
+	for(unsigned k=0; k<guard.size() && guard[k] != '_'; k++)
+		guard[k] = toupper(guard[k]);
+
+	assert(na+nb <= 64);
+	pmask = (na+nb >= 64) ? ~0ul : ((1ul << (na+nb))-1);
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.h\n"
+"//\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:	A cycle-accurate C++ model of the %s core.  It has\n"
+"//		the same ports, and the same i_ce, %s, and i_aux\n"
+"//	behavior, as the Verilated model--only faster, since the product is\n"
+"//	found with a native multiply and then simply delayed by %d clock%s.\n"
+"//	This file is computer generated, so please don't edit it.\n"
+"//\n"
+"%s"
+"//\n"
+"%s",
+		name, prjname, name+1, rstname, delay, (delay!=1)?"s":"",
+		creator, cpyleft);
+
+	fprintf(fp, "#ifndef\t%s_H\n#define\t%s_H\n\n", guard.c_str(),
+		guard.c_str());
+	fprintf(fp, "#include <stdint.h>\n\n");
+
+	fprintf(fp, "class\t%s {\n", name);
+	fprintf(fp, "\tstatic const int\tDELAY = %d;\n\n", delay);
+	// A core without registers has no state at all
+	if (delay > 0) {
+		fprintf(fp, "\t// The products (and aux bits) in flight, in a circular buffer.\n"
+			"\t// m_pipe[m_head] is both the oldest, and the one on o_p.\n");
+		fprintf(fp, "\t%s\tm_pipe[DELAY];\n", vltype(na+nb));
+		if (aux)
+			fprintf(fp, "\tuint8_t \tm_aux[DELAY];\n");
+		fprintf(fp, "\tint\t\tm_head;\n"
+			"\tuint8_t \tm_lastclk;\n"
+			"\tbool\t\tm_started;\n\n");
+
+		fprintf(fp,
+"\tvoid\tclear(void) {\n"
+"\t\tfor(int k=0; k<DELAY; k++) {\n"
+"\t\t\tm_pipe[k] = 0;\n%s"
+"\t\t}\n"
+"\t\tm_head = 0;\n"
+"\t}\n\n",
+			(aux) ? "\t\t\tm_aux[k] = 0;\n" : "");
+	}
+
+	fprintf(fp, "public:\n");
+	fprintf(fp, "\tuint8_t \ti_clk, %s, i_ce;\n", rstname);
+	fprintf(fp, "\t%s\ti_a;\n", vltype(na));
+	fprintf(fp, "\t%s\ti_b;\n", vltype(nb));
+	if (aux)
+		fprintf(fp, "\tuint8_t \ti_aux;\n");
+	fprintf(fp, "\t%s\to_p;\n", vltype(na+nb));
+	if (aux)
+		fprintf(fp, "\tuint8_t \to_aux;\n");
+
+	fprintf(fp, "\n\t%s(void) {\n"
+		"\t\ti_clk = 0;\n"
+		"\t\t%s = %d;\n"
+		"\t\ti_ce = 0;\n"
+		"\t\ti_a = 0;\n"
+		"\t\ti_b = 0;\n%s"
+		"\t\to_p = 0;\n%s%s"
+		"\t}\n\n",
+		name, rstname, (async_reset)?1:0,
+		(aux) ? "\t\ti_aux = 0;\n" : "",
+		(aux) ? "\t\to_aux = 0;\n" : "",
+		(delay > 0) ? "\t\tm_lastclk = 0;\n"
+			"\t\tm_started = false;\n"
+			"\t\tclear();\n" : "");
+
+	fprintf(fp, "\t// The product, in as many bits as o_p has\n");
+	fprintf(fp, "\t%s\tproduct(void) const {\n", vltype(na+nb));
+	if (sgn) {
+		fprintf(fp,
+		"\t\tint64_t\ta = (int64_t)((uint64_t)i_a << %d) >> %d,\n"
+		"\t\t\tb = (int64_t)((uint64_t)i_b << %d) >> %d;\n\n"
+		"\t\treturn (%s)((uint64_t)(a * b) & 0x%lxul);\n",
+			64-na, 64-na, 64-nb, 64-nb, vltype(na+nb), pmask);
+	} else {
+		fprintf(fp,
+		"\t\tuint64_t\ta = i_a & 0x%lxul, b = i_b & 0x%lxul;\n\n"
+		"\t\treturn (%s)((a * b) & 0x%lxul);\n",
+			(1ul << na)-1, (1ul << nb)-1, vltype(na+nb), pmask);
+	}
+	fprintf(fp, "\t}\n\n");
+
+	if (delay == 0) {
+		fprintf(fp, "\tvoid\teval(void) {\n"
+			"\t\to_p = product();\n");
+		if (aux)
+			fprintf(fp, "\t\to_aux = i_aux & 1;\n");
+		fprintf(fp, "\t}\n\n");
+	} else {
+		fprintf(fp, "\tvoid\teval(void) {\n"
+			"\t\t// As with Verilator, the first call never sees a clock edge\n"
+			"\t\tbool\tposedge = (m_started)&&(i_clk)&&(!m_lastclk);\n\n"
+			"\t\tm_started = true;\n"
+			"\t\tm_lastclk = i_clk;\n\n");
+		if (async_reset)
+			fprintf(fp, "\t\tif (!i_areset_n)\n"
+				"\t\t\tclear();\n"
+				"\t\telse if ((posedge)&&(i_ce)) {\n");
+		else
+			fprintf(fp, "\t\tif ((posedge)&&(i_reset))\n"
+				"\t\t\tclear();\n"
+				"\t\telse if ((posedge)&&(i_ce)) {\n");
+		fprintf(fp, "\t\t\tm_pipe[m_head] = product();\n");
+		if (aux)
+			fprintf(fp, "\t\t\tm_aux[m_head] = i_aux & 1;\n");
+		fprintf(fp, "\t\t\tm_head = (m_head+1 < DELAY) ? m_head+1 : 0;\n"
+			"\t\t}\n\n"
+			"\t\to_p = m_pipe[m_head];\n");
+		if (aux)
+			fprintf(fp, "\t\to_aux = m_aux[m_head];\n");
+		fprintf(fp, "\t}\n\n");
+	}
+
+	fprintf(fp, "\tvoid\tfinal(void) {}\n};\n\n");
+	fprintf(fp, "#endif\t// %s_H\n", guard.c_str());
+}
+
+//
+// buildlanes
+//
+// Writes a wrapper holding lanes copies of the given core, side by side,
+// with every lane's operands and products packed into one wide port.  Each
+// lane shares the clock, reset, and clock enable, so a Verilated wrapper
+// multiplies lanes pairs of operands for every eval().
+//
+void	buildlanes(FILE *fp, const char *name, const char *core,
+		const int na, const int nb, const int lanes,
+		const bool aux, const bool async_reset) {
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//\t\t\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\t%d copies of %s, side by side, with their operands and\n"
+"//\t\tproducts packed into wide ports, lane zero in the low bits.\n"
+"//\tThis file is computer generated, so please don't edit it.\n"
+"//\n"
+"//\n%s"
+"//\n", name, prjname, lanes, core, creator);
+
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a, i_b%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NB=%d, LANES=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\t[(LANES*NA-1):0]\ti_a;\n"
+		"\tinput\t\t[(LANES*NB-1):0]\ti_b;\n",
+		na, nb, lanes, rstname);
+	if (aux) fprintf(fp, "\tinput\t\t[(LANES-1):0]\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t[(LANES*(NA+NB)-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t[(LANES-1):0]\t\to_aux;\n");
+
+	fprintf(fp, "\n"
+"\tgenvar\tk;\n"
+"\tgenerate for(k=0; k<LANES; k=k+1)\n"
+"\tbegin : LANE\n"
+"\t\t%s\tmpy(i_clk, %s, i_ce,\n"
+"\t\t\ti_a[k*NA +: NA], i_b[k*NB +: NB],%s\n"
+"\t\t\to_p[k*(NA+NB) +: (NA+NB)]%s);\n"
+"\tend endgenerate\n",
+		core, rstname, (aux)?" i_aux[k],":"",
+		(aux)?", o_aux[k]":"");
+
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// csd
+//
+// The canonical signed digit form of v: LSB first, each digit -1, 0, or 1,
+// with no two non-zero digits next to each other.
+//
+std::vector<int>	csd(long v) {
+	std::vector<int>	d;
+
+	while(v != 0) {
+		int	r = 0;
+
+		// Odd values end in +1 if v%4 == 1, or in -1 if v%4 == 3,
+		// leaving the next digit zero either way
+		if (v & 1)
+			r = 2 - (int)(v & 3);
+		d.push_back(r);
+		v = (v - r) / 2;
+	}
+
+	return d;
+}
+
+// Bits needed to hold v in two's complement
+int	sbits(long v) {
+	int	k = 1;
+
+	while((v < -(1l << (k-1)))||(v >= (1l << (k-1))))
+		k++;
+	return k;
+}
+
+// Bits needed to hold every one of a set of constants
+int	constbits(const std::vector<long> &coefs) {
+	int	nb = 1;
+
+	for(unsigned k=0; k<coefs.size(); k++)
+		nb = std::max(nb, sbits(coefs[k]));
+	return nb;
+}
+
+//
+// CTERM
+//
+// sign * (node id << shift), one term of the sum making up a constant.
+//
+typedef	struct {
+	int	id, shift, sign;
+} CTERM;
+
+//
+// CNODE
+//
+// One adder (or subtractor) of a constant multiply, a * (x << ashift) plus
+// bsign * (b << bshift), or just the one term if there's no b (b < 0).  Node
+// zero is i_a itself.  coef is the constant the node multiplies i_a by, and
+// level the clock it's registered on the end of, counting from one.
+//
+typedef	struct {
+	int	a, ashift, asign, b, bshift, bsign;
+	long	coef;
+	int	level, width;
+} CNODE;
+
+//
+// csdshare
+//
+// Rewrites the CSD terms of every constant in terms of shared
+// subexpressions, as Hartley did: the most common pair of terms, the same
+// distance apart and with the same relative sign, wherever it appears in
+// any constant, becomes a node of its own, computed once.  This repeats
+// until no pair appears more than once.
+//
+void	csdshare(std::vector<std::vector<CTERM> > &terms,
+		std::vector<CNODE> &nodes, const int na, const int np) {
+	while(true) {
+		std::vector<std::vector<int> >	keys;
+		std::vector<int>	counts;
+		int	best = -1;
+
+		for(unsigned c=0; c<terms.size(); c++)
+		for(unsigned p=0; p<terms[c].size(); p++)
+		for(unsigned q=0; q<terms[c].size(); q++) {
+			const CTERM	&tp = terms[c][p], &tq = terms[c][q];
+			std::vector<int>	key(4);
+			unsigned		k;
+
+			if ((tp.shift > tq.shift)||((tp.shift == tq.shift)
+					&&(tp.id >= tq.id)))
+				continue;
+			key[0] = tp.id;
+			key[1] = tq.id;
+			key[2] = tq.shift - tp.shift;
+			key[3] = tp.sign * tq.sign;
+
+			for(k=0; k<keys.size(); k++)
+				if (keys[k] == key)
+					break;
+			if (k < keys.size())
+				counts[k]++;
+			else {
+				keys.push_back(key);
+				counts.push_back(1);
+			}
+		}
+
+		for(unsigned k=0; k<keys.size(); k++)
+			if ((counts[k] > 1)&&((best < 0)||(counts[k] > counts[best])))
+				best = k;
+		if (best < 0)
+			return;
+
+		// The new node, a + s * (b << d), negated if need be so that
+		// it's positive
+		CNODE		n;
+		const int	id = nodes.size();
+		int		nsign;
+
+		n.a = keys[best][0];	n.ashift = 0;
+		n.b = keys[best][1];	n.bshift = keys[best][2];
+		n.coef = nodes[n.a].coef
+			+ keys[best][3] * nodes[n.b].coef * (1l << n.bshift);
+		nsign = (n.coef < 0) ? -1 : 1;
+		n.asign = nsign;
+		n.bsign = keys[best][3] * nsign;
+		n.coef *= nsign;
+		n.level = std::max(nodes[n.a].level, nodes[n.b].level) + 1;
+		n.width = std::min(np, na + sbits(n.coef));
+		nodes.push_back(n);
+
+		// Replace every pair that matches, each term only once
+		for(unsigned c=0; c<terms.size(); c++) {
+			std::vector<bool>	used(terms[c].size(), false);
+			std::vector<CTERM>	next;
+
+			for(unsigned p=0; p<terms[c].size(); p++)
+			for(unsigned q=0; q<terms[c].size(); q++) {
+				const CTERM	&tp = terms[c][p], &tq = terms[c][q];
+
+				if ((used[p])||(used[q])||(p == q)
+					||(tp.id != n.a)||(tq.id != n.b)
+					||(tq.shift - tp.shift != n.bshift)
+					||(tp.sign * tq.sign != keys[best][3]))
+					continue;
+
+				CTERM	t;
+				t.id = id;
+				t.shift = tp.shift;
+				t.sign = tp.sign * nsign;
+				next.push_back(t);
+				used[p] = used[q] = true;
+			}
+
+			for(unsigned p=0; p<terms[c].size(); p++)
+				if (!used[p])
+					next.push_back(terms[c][p]);
+			terms[c] = next;
+		}
+	}
+}
+
+//
+// constadd
+//
+// A node adding two terms together, relative to the lower of their shifts
+// and positive where it can be, returned as a term carrying the rest.  With
+// no v, the node shifts and negates the one term instead, leaving nothing
+// for the term to carry.  Either way, it takes a clock.
+//
+CTERM	constadd(std::vector<CNODE> &nodes, const CTERM &u, const CTERM *v,
+		const int na, const int np) {
+	CNODE	n;
+	CTERM	r;
+
+	r.id = nodes.size();
+	r.shift = (v) ? std::min(u.shift, v->shift) : 0;
+	r.sign = ((v)&&(u.sign < 0)&&(v->sign < 0)) ? -1 : 1;
+
+	n.a = u.id;
+	n.ashift = u.shift - r.shift;
+	n.asign = u.sign * r.sign;
+	n.coef = n.asign * nodes[n.a].coef * (1l << n.ashift);
+	n.level = nodes[n.a].level + 1;
+	if (v) {
+		n.b = v->id;
+		n.bshift = v->shift - r.shift;
+		n.bsign = v->sign * r.sign;
+		n.coef += n.bsign * nodes[n.b].coef * (1l << n.bshift);
+		n.level = std::max(n.level, nodes[n.b].level + 1);
+	} else {
+		n.b = -1;
+		n.bshift = 0;
+		n.bsign = 1;
+	}
+	n.width = std::min(np, na + sbits(n.coef));
+	nodes.push_back(n);
+
+	return r;
+}
+
+//
+// constsched
+//
+// Builds every node a set of constant multiplies needs: the shared
+// subexpressions first, and then an adder tree for each constant, always
+// adding together the two terms that are ready soonest.  Each constant's
+// product ends up in a node of its own, in final[], unless it's zero (-1)
+// or the same as an earlier constant's.
+// Returns the number of clocks, the level of the last of them.
+//
+int	constsched(const std::vector<long> &coefs, const int na, const int np,
+		std::vector<CNODE> &nodes, std::vector<int> &final) {
+	std::vector<std::vector<CTERM> >	terms;
+	CNODE	x;
+	int	clocks = 1;
+
+	x.a = x.b = -1;
+	x.ashift = x.bshift = 0;
+	x.asign = x.bsign = 1;
+	x.coef = 1;
+	x.level = 0;
+	x.width = na;
+	nodes.clear();
+	nodes.push_back(x);
+
+	for(unsigned c=0; c<coefs.size(); c++) {
+		const std::vector<int>	d = csd(coefs[c]);
+		std::vector<CTERM>	t;
+
+		// A repeated constant shares the first one's product
+		if (std::find(coefs.begin(), coefs.begin()+c, coefs[c])
+				!= coefs.begin()+c) {
+			terms.push_back(t);
+			continue;
+		}
+
+		for(unsigned k=0; k<d.size(); k++) {
+			if (d[k] == 0)
+				continue;
+			CTERM	tk;
+			tk.id = 0;
+			tk.shift = k;
+			tk.sign = d[k];
+			t.push_back(tk);
+		}
+		terms.push_back(t);
+	}
+
+	csdshare(terms, nodes, na, np);
+
+	final.clear();
+	for(unsigned c=0; c<terms.size(); c++) {
+		std::vector<CTERM>	t = terms[c];
+
+		if (t.size() == 0) {
+			unsigned	j = std::find(coefs.begin(), coefs.end(),
+						coefs[c]) - coefs.begin();
+
+			final.push_back((j < c) ? final[j] : -1);
+			continue;
+		}
+
+		while(t.size() > 1) {
+			unsigned	p = 0, q;
+
+			// The two terms that are ready first
+			for(unsigned k=1; k<t.size(); k++)
+				if (nodes[t[k].id].level < nodes[t[p].id].level)
+					p = k;
+			q = (p == 0) ? 1 : 0;
+			for(unsigned k=0; k<t.size(); k++)
+				if ((k != p)&&(nodes[t[k].id].level
+						< nodes[t[q].id].level))
+					q = k;
+
+			const CTERM	s = constadd(nodes, t[p], &t[q], na, np);
+			t.erase(t.begin() + std::max(p, q));
+			t.erase(t.begin() + std::min(p, q));
+			t.push_back(s);
+		}
+
+		// The product itself, with nothing left to shift or negate
+		if ((t[0].id == 0)||(t[0].shift != 0)||(t[0].sign < 0))
+			t[0] = constadd(nodes, t[0], NULL, na, np);
+
+		assert(nodes[t[0].id].coef == coefs[c]);
+		final.push_back(t[0].id);
+		clocks = std::max(clocks, nodes[t[0].id].level);
+	}
+
+	return clocks;
+}
+
+//
+// constname
+//
+// The name of node id, delayed until it's an input to clock lvl.  Node
+// zero, i_a, is an input to clock zero.
+//
+std::string	constname(const int id, const int lvl, const int level) {
+	char	str[64];
+
+	if ((id == 0)&&(lvl == 0))
+		return "i_a";
+	else if (lvl == level)
+		sprintf(str, "K_%02d", id);
+	else
+		sprintf(str, "K_%02d_%d", id, lvl);
+	return str;
+}
+
+//
+// constterm
+//
+// name, a w-bit signed value, shifted up by shift and sign extended (or
+// truncated) to width bits.
+//
+std::string	constterm(const std::string &name, const int w,
+		const int shift, const int width) {
+	std::string	r;
+	char		str[64];
+
+	if (shift >= width) {
+		sprintf(str, "%d\'b0", width);
+		return str;
+	}
+
+	if (w + shift < width) {
+		sprintf(str, "{(%d){%s[%d]}}, ", width - w - shift,
+			name.c_str(), w-1);
+		r = str;
+	}
+	if (w + shift > width) {
+		sprintf(str, "[%d:0]", width - shift - 1);
+		r += name + str;
+	} else
+		r += name;
+	if (shift > 0) {
+		sprintf(str, ", %d\'b0", shift);
+		r += str;
+	}
+
+	if (r == name)
+		return r;
+	return "{ " + r + " }";
+}
+
+//
+// buildconstmpy
+//
+// Writes a core multiplying i_a, signed, by each of a set of constants,
+// from nothing but shifts and adds.  Each constant is recoded into canonical
+// signed digits, subexpressions common to any of them are found once, and
+// every adder is followed by a register.  The products come out side by
+// side on o_p, the first constant's at the bottom, each as wide as the
+// widest constant and i_a together, and all after the same number of
+// clocks.
+//
+void	buildconstmpy(FILE *fp, const char *name, const int na,
+		const std::vector<long> &coefs, const bool aux,
+		const bool async_reset) {
+	std::vector<CNODE>	nodes;
+	std::vector<int>	final, needed;
+	const int	np = na + constbits(coefs);
+	int		clocks;
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::string	always_reset = "\talways @(posedge i_clk)\n\tif(i_reset)\n";
+	if (async_reset)
+		always_reset = "\talways @(posedge i_clk, negedge i_areset_n)\n\tif(!i_areset_n)\n";
+
+	clocks = constsched(coefs, na, np, nodes, final);
+
+	// How long each node needs to be kept, for the nodes that use it, and
+	// for o_p
+	needed.assign(nodes.size(), 0);
+	for(unsigned k=0; k<nodes.size(); k++) {
+		needed[k] = std::max(needed[k], nodes[k].level);
+		if (nodes[k].a >= 0)
+			needed[nodes[k].a] = std::max(needed[nodes[k].a],
+				nodes[k].level-1);
+		if (nodes[k].b >= 0)
+			needed[nodes[k].b] = std::max(needed[nodes[k].b],
+				nodes[k].level-1);
+	}
+	for(unsigned k=0; k<final.size(); k++)
+		if (final[k] >= 0)
+			needed[final[k]] = clocks;
+
+	fprintf(fp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.v\n"
+"//		\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:\tThis verilog file multiplies a signed number by %s,\n"
+"//\t\tusing only shifts and adds.  The products are placed side by\n"
+"//\tside in o_p, from the first constant in the LSBs to the last.  This\n"
+"//\tfile is computer generated, so please (for your sake) don\'t make any\n"
+"//\tedits to this file lest you regenerate it and your edits be lost.\n"
+"//\n"
+"//\tConstants:",
+		name, prjname, (coefs.size() > 1) ? "several constants"
+			: "a constant");
+	for(unsigned k=0; k<coefs.size(); k++)
+		fprintf(fp, "%s %ld", (k > 0) ? ",":"", coefs[k]);
+	fprintf(fp, "\n"
+"//\n"
+"//\n%s"
+"//\n", creator);
+
+	fprintf(fp, "%s", cpyleft);
+
+	fprintf(fp, "module %s(i_clk, %s, i_ce, i_a%s, o_p%s);\n",
+		name, rstname, (aux)?", i_aux":"", (aux)?", o_aux":"");
+	fprintf(fp,
+		"\tparameter\tNA=%d, NP=%d, NCOEFS=%d;\n"
+		"\tinput\t\t\t\t\ti_clk, %s, i_ce;\n"
+		"\tinput\t\tsigned\t[(NA-1):0]\ti_a;\n", na, np,
+		(int)coefs.size(), rstname);
+	if (aux) fprintf(fp, "\tinput\t\t\t\t\ti_aux;\n");
+	fprintf(fp, "\toutput\twire\t[(NCOEFS*NP-1):0]\to_p;\n");
+	if (aux) fprintf(fp, "\toutput\twire\t\t\t\to_aux;\n");
+
+	for(int clock=0; clock<clocks; clock++) {
+		std::vector<PPROW>		rows;
+		std::vector<std::string>	expr;
+
+		fprintf(fp, "\n\t//\n\t// Clock %d\n\t//\n\n", clock);
+		for(unsigned k=1; k<nodes.size(); k++) {
+			const CNODE	&n = nodes[k];
+			std::string	ea, eb, e;
+			PPROW		r;
+
+			if (n.level != clock+1)
+				continue;
+
+			ea = constterm(constname(n.a, clock, nodes[n.a].level),
+				nodes[n.a].width, n.ashift, n.width);
+			if (n.b < 0)
+				e = ((n.asign < 0) ? "-" : "") + ea;
+			else {
+				eb = constterm(constname(n.b, clock,
+					nodes[n.b].level), nodes[n.b].width,
+					n.bshift, n.width);
+				if (n.asign > 0)
+					e = ea + ((n.bsign > 0) ? "\n\t\t\t+ " : "\n\t\t\t- ") + eb;
+				else {
+					assert(n.bsign > 0);
+					e = eb + "\n\t\t\t- " + ea;
+				}
+			}
+
+			r.name = constname(k, n.level, n.level);
+			r.lsb = 0;
+			r.width = n.width;
+			rows.push_back(r);
+			expr.push_back(e);
+		}
+
+		// Anything needed later is delayed
+		for(unsigned k=0; k<nodes.size(); k++) {
+			PPROW	r;
+
+			if ((nodes[k].level > clock)||(needed[k] <= clock))
+				continue;
+			r.name = constname(k, clock+1, nodes[k].level);
+			r.lsb = 0;
+			r.width = nodes[k].width;
+			rows.push_back(r);
+			expr.push_back(constname(k, clock, nodes[k].level));
+		}
+
+		buildstage(fp, rows, expr, clock, true, (aux)&&(clock > 0),
+			always_reset);
+		if ((aux)&&(clock == 0))
+			buildaux0(fp, always_reset);
+	}
+
+	fprintf(fp, "\n\tassign\to_p = {");
+	for(int k=final.size()-1; k>=0; k--) {
+		std::string	p;
+		char		str[64];
+
+		if (final[k] < 0) {
+			sprintf(str, "%d\'b0", np);
+			p = str;
+		} else
+			p = constterm(constname(final[k], clocks,
+				nodes[final[k]].level),
+				nodes[final[k]].width, 0, np);
+		fprintf(fp, "%s\n\t\t\t%s", (k+1 < (int)final.size()) ? ",":"",
+			p.c_str());
+	}
+	fprintf(fp, " };\n");
+	if (aux) fprintf(fp, "\tassign\to_aux = A_%d;\n", clocks-1);
+
+	// Every product is checked against i_a, clocks ago, times its
+	// constant
+	fprintf(fp, "\n\n`ifdef\tFORMAL\n\n");
+	fprintf(fp, "\treg\t[%d:0]\tf_apipe;\n"
+		"\twire\tsigned\t[NP-1:0]\tf_a;\n\n"
+		"\tinitial\tf_apipe = 0;\n%s"
+		"\t\tf_apipe <= 0;\n"
+		"\telse if (i_ce)\n", clocks*(na+1)-1, always_reset.c_str());
+	if (clocks > 1)
+		fprintf(fp, "\t\tf_apipe <= { f_apipe[%d:0], %s, i_a };\n",
+			(clocks-1)*(na+1)-1, (aux) ? "i_aux" : "1\'b0");
+	else
+		fprintf(fp, "\t\tf_apipe <= { %s, i_a };\n",
+			(aux) ? "i_aux" : "1\'b0");
+	fprintf(fp, "\n\tassign\tf_a = { {(NP-NA){f_apipe[%d]}}, f_apipe[%d:%d] };\n\n",
+		clocks*(na+1)-2, clocks*(na+1)-2, (clocks-1)*(na+1));
+	for(unsigned k=0; k<coefs.size(); k++)
+		fprintf(fp, "\talways @(*)\n"
+			"\t\tassert(o_p[%d*NP +: NP] == f_a * %s%d\'sd%ld);\n",
+			k, (coefs[k] < 0) ? "-":"", np, labs(coefs[k]));
+	if (aux)
+		fprintf(fp, "\talways @(*)\n"
+			"\t\tassert(o_aux == f_apipe[%d]);\n",
+			clocks*(na+1)-1);
+	fprintf(fp, "\n`endif\n");
+	fprintf(fp, "\nendmodule\n");
+}
+
+//
+// descopen
+//
+// Starts both halves of a core's description: the banner and include guard
+// of its C header, and the name in its JSON.  purpose is the banner's text,
+// with a %s for the core's name.  Returns the prefix of the header's defines.
+//
+std::string	descopen(FILE *hp, FILE *jp, const char *name,
+		const char *purpose) {
+	std::string	prefix = name;
+
+	// Upper case the core type, but not the "x" in its size
+	for(unsigned k=0; k<prefix.size() && prefix[k] != '_'; k++)
+		prefix[k] = toupper(prefix[k]);
+
+	fprintf(hp,
+"////////////////////////////////////////////////////////////////////////////////\n"
+"//\n"
+"// Filename: 	%s.h\n"
+"//\n"
+"// Project:	%s\n"
+"//\n"
+"// Purpose:	", name, prjname);
+	fprintf(hp, purpose, name);
+	fprintf(hp, "//\n%s//\n%s", creator, cpyleft);
+	fprintf(hp, "#ifndef\t%s_H\n#define\t%s_H\n\n",
+		prefix.c_str(), prefix.c_str());
+
+	fprintf(jp, "{\n");
+	fprintf(jp, "\t\"name\": \"%s\",\n", name);
+	return prefix;
+}
+
+//
+// descint, descbool
+//
+// One field of a description: a define in the header, and the same name in
+// lower case in the JSON.  The header gives a flag as 1 or 0.
+//
+void	descint(FILE *hp, FILE *jp, const std::string &prefix,
+		const char *key, const int v) {
+	std::string	jkey = key;
+
+	for(unsigned k=0; k<jkey.size(); k++)
+		jkey[k] = tolower(jkey[k]);
+	fprintf(hp, "#define\t%-27s %d\n", (prefix+"_"+key).c_str(), v);
+	fprintf(jp, "\t\"%s\": %d,\n", jkey.c_str(), v);
+}
+
+void	descbool(FILE *hp, FILE *jp, const std::string &prefix,
+		const char *key, const bool v) {
+	std::string	jkey = key;
+
+	for(unsigned k=0; k<jkey.size(); k++)
+		jkey[k] = tolower(jkey[k]);
+	fprintf(hp, "#define\t%-27s %d\n", (prefix+"_"+key).c_str(), v?1:0);
+	fprintf(jp, "\t\"%s\": %s,\n", jkey.c_str(), v ? "true":"false");
+}
+
+//
+// descclose
+//
+// Finishes a description with what every core has: its aux and reset
+// options, and its ports.  ports lists the core's own ports, after the
+// clock, reset and clock enable, as pairs of a define suffix and a port
+// name, ending with a NULL.
+//
+void	descclose(FILE *hp, FILE *jp, const std::string &prefix,
+		const char *const *ports, const bool aux,
+		const bool async_reset) {
+	const char	*rstname = (async_reset) ? "i_areset_n" : "i_reset";
+	std::vector<const char *>	plist;
+
+	plist.push_back("CLOCK");	plist.push_back("i_clk");
+	plist.push_back("RESET");	plist.push_back(rstname);
+	plist.push_back("CE");		plist.push_back("i_ce");
+	for(unsigned k=0; ports[k]; k+=2) {
+		plist.push_back(ports[k]);
+		plist.push_back(ports[k+1]);
+	}
+	if (aux) {
+		plist.push_back("IAUX");	plist.push_back("i_aux");
+		plist.push_back("OAUX");	plist.push_back("o_aux");
+	}
+
+	descbool(hp, jp, prefix, "AUX", aux);
+	fprintf(hp, "#define\t%-27s %d\n", (prefix+"_ASYNC_RESET").c_str(),
+		async_reset?1:0);
+	fprintf(jp, "\t\"reset\": \"%s\",\n", async_reset ? "async":"sync");
+
+	fprintf(jp, "\t\"ports\": {\n");
+	for(unsigned k=0; k<plist.size(); k+=2) {
+		std::string	jkey = plist[k];
+
+		for(unsigned j=0; j<jkey.size(); j++)
+			jkey[j] = tolower(jkey[j]);
+		fprintf(hp, "#define\t%-27s \"%s\"\n",
+			(prefix+"_"+plist[k]).c_str(), plist[k+1]);
+		fprintf(jp, "\t\t\"%s\": \"%s\"%s\n", jkey.c_str(), plist[k+1],
+			(k+2 < plist.size()) ? ",":"");
+	}
+	fprintf(hp, "\n#endif\t// %s_H\n", prefix.c_str());
+	fprintf(jp, "\t}\n");
+	fprintf(jp, "}\n");
+}
+
+//
+// builddesc
+//
+// Writes a machine readable description of a core, both as a C header for
+// the test benches and as JSON for anything else.  Everything here must
+// match what buildumpy() and buildsmpy() actually generated.  The header
+// defines are all prefixed by the upper case core name, so that headers for
+// many cores can be included together.
+//
+void	builddesc(FILE *hp, FILE *jp, const char *name,
+		const int premul, const int na, const int nb, const bool sgn,
+		const bool aux, const bool async_reset) {
+	static const char *const ports[] = {
+		"A", "i_a", "B", "i_b", "P", "o_p", NULL };
+	std::string	prefix;
+	int		delay, param, tile, dsp = 0;
+	const char	*pname;
+	bool		booth, bw, karatsuba;
+
+	booth = (sgn)&&(booth_flag);
+	bw = (sgn)&&(bw_flag)&&(!booth);
+	tile = (tiled(na, nb)) ? tile_size : 0;
+	if (dsp_na > 0) {
+		// Hard multipliers, in either core
+		const DSPTILES	t = dsptiles(na, nb);
+		dsp = t.ka * t.kb;
+	}
+	karatsuba = (tile > 0)&&(karatsuba_flag);
+	delay = latency(premul, na, nb, sgn);
+	param = delay-1;
+	pname = (sgn)&&(!booth)&&(!bw) ? "DLY" : "F_DELAY";
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s core: its widths, latency, ports and reset\n"
+"//		style.  This file is computer generated, together with the\n"
+"//	core itself, so please don't edit it.\n");
+	descint(hp, jp, prefix, "NA", na);
+	descint(hp, jp, prefix, "NB", nb);
+	descint(hp, jp, prefix, "NP", na+nb);
+	descbool(hp, jp, prefix, "SIGNED", sgn);
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descbool(hp, jp, prefix, "BOOTH", booth);
+	descbool(hp, jp, prefix, "BAUGH_WOOLEY", bw);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	descint(hp, jp, prefix, "TILE", tile);
+	descbool(hp, jp, prefix, "KARATSUBA", karatsuba);
+	descint(hp, jp, prefix, "DSP_TILES", dsp);
+	// Whether buildcmpy() wrote a C++ model of this core as well
+	descbool(hp, jp, prefix, "HAS_CMODEL", (na+nb <= 64));
+	fprintf(hp, "// Clocks (with i_ce) from i_a and i_b to o_p\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	if (delay > 0) {
+		fprintf(hp, "#define\t%-27s %d\n",
+			(prefix+"_"+pname).c_str(), param);
+		fprintf(jp, "\t\"parameters\": { \"%s\": %d },\n",
+			pname, param);
+	} else
+		// Without any registers, there's no pipeline to size
+		fprintf(jp, "\t\"parameters\": { },\n");
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// buildmacdesc
+//
+// The description of a MAC core, as builddesc() writes for the multiplies.
+//
+void	buildmacdesc(FILE *hp, FILE *jp, const char *name, const int premul,
+		const int na, const int nb, const int nacc, const bool sgn,
+		const bool aux, const bool async_reset) {
+	static const char *const ports[] = {
+		"CLR", "i_clr", "A", "i_a", "B", "i_b", "ACC", "o_acc", NULL };
+	std::string	prefix;
+	const int	delay = macstages(premul, std::min(na, nb),
+					std::max(na, nb));
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s multiply-accumulate core: its widths,\n"
+"//		latency, ports and reset style.  This file is computer\n"
+"//	generated, together with the core itself, so please don't edit it.\n");
+	descint(hp, jp, prefix, "NA", na);
+	descint(hp, jp, prefix, "NB", nb);
+	descint(hp, jp, prefix, "NACC", nacc);
+	descbool(hp, jp, prefix, "SIGNED", sgn);
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	fprintf(hp, "// Clocks (with i_ce) from i_a, i_b, and i_clr to o_acc\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// buildtruncdesc
+//
+// The description of a truncated core, as builddesc() writes for the
+// general ones, with the bounds on its error.
+//
+void	buildtruncdesc(FILE *hp, FILE *jp, const char *name, const int premul,
+		const int na, const int nb, const int nout, const bool sgn,
+		const bool aux, const bool async_reset) {
+	static const char *const ports[] = {
+		"A", "i_a", "B", "i_b", "P", "o_p", NULL };
+	std::string	prefix;
+	const TRUNC	tr = truncation(std::min(na, nb), std::max(na, nb),
+				nout, sgn);
+	const int	delay = truncstages(premul, na, nb, nout);
+	char		elo[64], ehi[64];
+
+	sprintf(elo, (tr.elo < 0) ? "(%ldl)" : "%ldl", tr.elo);
+	sprintf(ehi, (tr.ehi < 0) ? "(%ldl)" : "%ldl", tr.ehi);
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s truncated multiply core: its widths,\n"
+"//		error bounds, latency, ports and reset style.  This file is\n"
+"//	computer generated, together with the core itself, so please don't\n"
+"//	edit it.\n");
+	descint(hp, jp, prefix, "NA", na);
+	descint(hp, jp, prefix, "NB", nb);
+	descint(hp, jp, prefix, "NP", na+nb);
+	descint(hp, jp, prefix, "NOUT", nout);
+	descbool(hp, jp, prefix, "SIGNED", sgn);
+	descbool(hp, jp, prefix, "ROUND", round_flag);
+	descbool(hp, jp, prefix, "VAR_COMP", varcomp_flag);
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	fprintf(hp, "// Columns of the product kept below o_p\n");
+	descint(hp, jp, prefix, "GUARD", na+nb-nout-tr.lo);
+	fprintf(hp, "// o_p<<(NP-NOUT) less the exact product, modulo 2^NP, lies within\n");
+	fprintf(hp, "#define\t%-27s %s\n", (prefix+"_ERR_LO").c_str(), elo);
+	fprintf(hp, "#define\t%-27s %s\n", (prefix+"_ERR_HI").c_str(), ehi);
+	fprintf(jp, "\t\"err_lo\": %ld,\n", tr.elo);
+	fprintf(jp, "\t\"err_hi\": %ld,\n", tr.ehi);
+	fprintf(hp, "// Clocks (with i_ce) from i_a and i_b to o_p\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// buildcmplxdesc
+//
+// The description of a complex multiply core, as builddesc() writes for the
+// general ones.
+//
+void	buildcmplxdesc(FILE *hp, FILE *jp, const char *name, const int premul,
+		const int na, const int nb, const bool aux,
+		const bool async_reset) {
+	static const char *const ports[] = {
+		"AR", "i_ar", "AI", "i_ai", "BR", "i_br", "BI", "i_bi",
+		"PR", "o_pr", "PI", "o_pi", NULL };
+	std::string	prefix;
+	const int	delay = cmplxstages(premul, na, nb);
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s complex multiply core: its widths,\n"
+"//		latency, ports and reset style.  This file is computer\n"
+"//	generated, together with the core itself, so please don't edit it.\n");
+	descint(hp, jp, prefix, "NA", na);
+	descint(hp, jp, prefix, "NB", nb);
+	fprintf(hp, "// Bits in each of the real and imaginary parts of the product\n");
+	descint(hp, jp, prefix, "NP", na+nb+1);
+	fprintf(jp, "\t\"signed\": true,\n");
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	fprintf(hp, "// Real multiplies (sgnmpy cores) used\n");
+	descint(hp, jp, prefix, "MPYS", 3);
+	fprintf(hp, "// Clocks (with i_ce) from the operands to the product\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// buildsimddesc
+//
+// The description of a packed SIMD core, as builddesc() writes for the
+// general ones.
+//
+void	buildsimddesc(FILE *hp, FILE *jp, const char *name, const int premul,
+		const int n, const int lane, const bool aux,
+		const bool async_reset) {
+	static const char *const ports[] = {
+		"MODE", "i_mode", "A", "i_a", "B", "i_b", "P", "o_p", NULL };
+	std::string	prefix;
+	const int	delay = simdstages(premul, n),
+			nmodes = simdmodes(n, lane);
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s packed SIMD multiply core: its widths,\n"
+"//		lanes, latency, ports and reset style.  This file is computer\n"
+"//	generated, together with the core itself, so please don't edit it.\n");
+	descint(hp, jp, prefix, "N", n);
+	descint(hp, jp, prefix, "NP", 2*n);
+	fprintf(jp, "\t\"signed\": false,\n");
+	fprintf(hp, "// The narrowest lane, and the number of lane widths i_mode\n"
+		"// picks from: N bits for zero, N/2 for one, and so on\n");
+	descint(hp, jp, prefix, "LANE", lane);
+	descint(hp, jp, prefix, "MODES", nmodes);
+	fprintf(hp, "#define\t%-27s %d\n", (prefix+"_MODE_BITS").c_str(),
+		lg(nmodes));
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	descint(hp, jp, prefix, "ROWS", npremul(premul, n, n));
+	fprintf(hp, "// Clocks (with i_ce) from i_mode, i_a and i_b to o_p\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// builddotdesc
+//
+// The description of a dot product core, as builddesc() writes for the
+// general ones.
+//
+void	builddotdesc(FILE *hp, FILE *jp, const char *name, const int premul,
+		const int n, const int na, const int nb, const bool sgn,
+		const bool aux, const bool async_reset) {
+	static const char *const ports[] = {
+		"A", "i_a", "B", "i_b", "P", "o_p", NULL };
+	std::string	prefix;
+	const int	delay = dotstages(premul, n, na, nb),
+			np = dotbits(n, na, nb);
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s dot product core: its widths, rows,\n"
+"//		latency, ports and reset style.  This file is computer\n"
+"//	generated, together with the core itself, so please don't edit it.\n");
+	fprintf(hp, "// Products added together, packed into i_a and i_b\n");
+	descint(hp, jp, prefix, "N", n);
+	descint(hp, jp, prefix, "NA", na);
+	descint(hp, jp, prefix, "NB", nb);
+	descint(hp, jp, prefix, "NP", np);
+	descbool(hp, jp, prefix, "SIGNED", sgn);
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	fprintf(hp, "// Rows of all of the tableaus together\n");
+	descint(hp, jp, prefix, "ROWS", n * npremul(premul, na, nb));
+	fprintf(hp, "// Clocks (with i_ce) from i_a and i_b to o_p\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// buildsqrdesc
+//
+// The description of a squaring core, as builddesc() writes for the general
+// ones, with the rows of its tableau.
+//
+void	buildsqrdesc(FILE *hp, FILE *jp, const char *name, const int premul,
+		const int n, const bool sgn, const bool aux,
+		const bool async_reset) {
+	static const char *const ports[] = { "A", "i_a", "P", "o_p", NULL };
+	std::string	prefix;
+	const int	delay = sqrstages(premul, n);
+	int		nbits, nwide = sqrrows(premul, n, nbits);
+
+	prefix = descopen(hp, jp, name,
+"Describes the %s squaring core: its widths, rows,\n"
+"//		latency, ports and reset style.  This file is computer\n"
+"//	generated, together with the core itself, so please don't edit it.\n");
+	descint(hp, jp, prefix, "N", n);
+	descint(hp, jp, prefix, "NP", 2*n);
+	descbool(hp, jp, prefix, "SIGNED", sgn);
+	descint(hp, jp, prefix, "PREMUL", premul);
+	descint(hp, jp, prefix, "CSA_LAYERS", csa_layers);
+	fprintf(hp, "// Rows of the tableau, and how many of them are single bits\n");
+	descint(hp, jp, prefix, "ROWS", nwide + nbits);
+	descint(hp, jp, prefix, "BIT_ROWS", nbits);
+	fprintf(hp, "// Clocks (with i_ce) from i_a to o_p\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
+
+//
+// buildconstdesc
+//
+// The description of a constant multiply core, as builddesc() writes for the
+// general ones.
+//
+void	buildconstdesc(FILE *hp, FILE *jp, const char *name, const int na,
+		const std::vector<long> &coefs, const bool aux,
+		const bool async_reset) {
+	static const char *const ports[] = { "A", "i_a", "P", "o_p", NULL };
+	std::string	prefix;
+	std::vector<CNODE>	nodes;
+	std::vector<int>	final;
+	const int	nb = constbits(coefs);
+	const int	delay = constsched(coefs, na, na+nb, nodes, final);
+	int		adders = 0;
+	std::string	clist;
+	char		str[64];
 
-		fprintf(fp, "\tinitial\tassert(f_auxpipe == 0);\n");
-		fprintf(fp, "\talways @(posedge i_clk)\n");
-		fprintf(fp, "\tif ((f_past_valid)&&($past(%s)))\n",
-			(async_reset)?"!i_areset_n":"i_reset");
-		fprintf(fp, "\t\tassert(f_auxpipe == 0);\n");
-		fprintf(fp, "\talways @(posedge i_clk)\n");
-		fprintf(fp, "\tif ((f_past_valid)&&(!$past(%s))&&($past(i_ce)))\n",
-			(async_reset)?"!i_areset_n":"i_reset");
-		fprintf(fp, "\t\tassert(f_auxpipe[%d+1:1] == $past(f_auxpipe[%d:0]));\n\n", clock,clock);
-		fprintf(fp, "\talways @(posedge i_clk)\n");
-		fprintf(fp, "\tif ((f_past_valid)&&(!$past(%s))&&(!$past(i_ce)))\n",
-			(async_reset)?"!i_areset_n":"i_reset");
-		fprintf(fp, "\t\tassert(f_auxpipe[%d+1:1] == $past(f_auxpipe[%d+1:1]));\n\n", clock,clock);
+	for(unsigned k=0; k<nodes.size(); k++)
+		if (nodes[k].b >= 0)
+			adders++;
+	for(unsigned k=0; k<coefs.size(); k++) {
+		sprintf(str, "%s%ld", (k > 0) ? ", ":"", coefs[k]);
+		clist += str;
 	}
 
+	prefix = descopen(hp, jp, name,
+"Describes the %s constant multiply core: its widths,\n"
+"//		constants, latency, ports and reset style.  This file is\n"
+"//	computer generated, together with the core itself, so please don't\n"
+"//	edit it.\n");
+	descint(hp, jp, prefix, "NA", na);
+	fprintf(hp, "// Bits in the widest constant, and in each product\n");
+	descint(hp, jp, prefix, "NB", nb);
+	descint(hp, jp, prefix, "NP", na+nb);
+	fprintf(jp, "\t\"signed\": true,\n");
+	descint(hp, jp, prefix, "NCOEFS", (int)coefs.size());
+	fprintf(hp, "#define\t%-27s { %s }\n", (prefix+"_COEFS").c_str(),
+		clist.c_str());
+	fprintf(jp, "\t\"coefs\": [ %s ],\n", clist.c_str());
+	descint(hp, jp, prefix, "ADDERS", adders);
+	fprintf(hp, "// Clocks (with i_ce) from i_a to o_p\n");
+	descint(hp, jp, prefix, "DELAY", delay);
+	descclose(hp, jp, prefix, ports, aux, async_reset);
+}
 
+//
+// openout
+//
+// Opens a generated file for writing, within dir if given, and quits if it
+// cannot be opened.
+//
+FILE	*openout(const char *dir, const char *fname) {
+	FILE	*fp;
+	std::string	path = fname;
 
-	fprintf(fp,
-	"\tlocalparam\tF_DELAY = %d;\n", clock);
-	fprintf(fp,
-	"\treg	[NA+NB-1:0]	f_result;\n"
-	"\tinteger\t\t\tik;\n"
-	"\n\tinitial\tf_result = 0;\n"
-	"%s"
-		"\t\tf_result = 0;\n"
-		"\telse if (i_ce)\n"
-		"\tbegin\n"
-			"\t\tf_result = 0;\n"
-			"\t\tfor(ik=0; ik<NS; ik=ik+1)\n"
-			"\t\t\tif(i_a[ik])\n"
-			"\t\t\t\tf_result = f_result + { {(NL-ik-1){1\'b0}},\n"
-			"\t\t\t\t\t\ti_b, { (ik){1\'b0} } };\n"
-		"\tend\n"
-	"\n", always_reset.c_str());
-
-	fprintf(fp,
-	"\treg\t[F_DELAY*(NA+NB)-1:0]	f_result_pipe;\n"
-	"\n\tinitial\tf_result_pipe = 0;\n%s"
-		"\t\tf_result_pipe <= 0;\n"
-		"\telse if (i_ce)\n"
-		"\t\tf_result_pipe <= { f_result, f_result_pipe[((F_DELAY)*(NA+NB)-1):(NA+NB)] };\n"
-	"\n"
-		"\talways @(posedge i_clk)\n"
-		"\t\tassert(o_p == f_result_pipe[(NA+NB-1):0]);\n\n",
-		always_reset.c_str());
+	if (dir)
+		path = std::string(dir) + "/" + fname;
+	fp = fopen(path.c_str(), "w");
+	if (!fp) {
+		fprintf(stderr, "Could not open %s for writing\n", path.c_str());
+		perror("O/S Err:");
+		exit(EXIT_FAILURE);
+	} else if (verbose_flag) {
+		fprintf(stderr, "Writing %s\n", path.c_str());
+	}
 
-	fprintf(fp,
-	 	"\talways @(posedge i_clk)\n"
-	 	"\t\tassume((i_ce)\n"
-		"\t\t\t||((f_past_valid)&&($past(i_ce)))\n"
-		"\t\t\t// ||(($past(f_past_valid))&&($past(i_ce,2)))\n"
-		"\t\t\t);\n\n");
-	fprintf(fp, "`endif\n");
-	fprintf(fp, "\nendmodule\n");
+	return fp;
 }
 
-void buildmakinc(FILE *fp, const char *fname, const int Na, const int Nb) {
+void buildmakinc(FILE *fp, const char *fname, const int Na, const int Nb,
+		const int lanes, const int nacc, const int nout,
+		const bool cmplx, const int simd, const int ndot) {
 	fprintf(fp, ".PHONY: umpy_%dx%d\n", Na, Nb);
 	fprintf(fp, "umpy_%dx%d: $(VDIRFB)/Vumpy_%dx%d__ALL.a\n", Na, Nb, Na, Nb);
 	fprintf(fp, "$(VDIRFB)/Vumpy_%dx%d.h: umpy_%dx%d.v\n", Na, Nb, Na, Nb);
@@ -752,46 +5119,288 @@ void buildmakinc(FILE *fp, const char *fname, const int Na, const int Nb) {
 		Na, Nb, Na, Nb);
 	fprintf(fp, "$(VDIRFB)/Vsgnmpy_%dx%d__ALL.a: $(VDIRFB)/Vsgnmpy_%dx%d.h\n"
 		"\t$(SUBMAKE) -f Vsgnmpy_%dx%d.mk\n", Na, Nb, Na, Nb, Na, Nb);
+
+	for(int k=0; k<6; k++) {
+		const char	*cores[6] = { "umac", "sgnmac", "umpyhi", "sgnmpyhi",
+					"cmplx", "usimd" };
+		const bool	built[6] = { (nacc > 0), (nacc > 0), (nout > 0),
+					(nout > 0), cmplx, (simd > 0) };
+		const char	*core = cores[k];
+
+		if (!built[k])
+			continue;
+
+		fprintf(fp, "\n");
+		fprintf(fp, ".PHONY: %s_%dx%d\n", core, Na, Nb);
+		fprintf(fp, "%s_%dx%d: $(VDIRFB)/V%s_%dx%d__ALL.a\n",
+			core, Na, Nb, core, Na, Nb);
+		fprintf(fp, "$(VDIRFB)/V%s_%dx%d.h: %s_%dx%d.v\n",
+			core, Na, Nb, core, Na, Nb);
+		fprintf(fp, "$(VDIRFB)/V%s_%dx%d__ALL.a: $(VDIRFB)/V%s_%dx%d.h\n"
+			"\t$(SUBMAKE) -f V%s_%dx%d.mk\n",
+			core, Na, Nb, core, Na, Nb, core, Na, Nb);
+	}
+
+	for(int k=0; (ndot > 0)&&(k<2); k++) {
+		char	core[64];
+
+		sprintf(core, "%sdot%d", (k == 0) ? "u" : "sgn", ndot);
+		fprintf(fp, "\n");
+		fprintf(fp, ".PHONY: %s_%dx%d\n", core, Na, Nb);
+		fprintf(fp, "%s_%dx%d: $(VDIRFB)/V%s_%dx%d__ALL.a\n",
+			core, Na, Nb, core, Na, Nb);
+		fprintf(fp, "$(VDIRFB)/V%s_%dx%d.h: %s_%dx%d.v\n",
+			core, Na, Nb, core, Na, Nb);
+		fprintf(fp, "$(VDIRFB)/V%s_%dx%d__ALL.a: $(VDIRFB)/V%s_%dx%d.h\n"
+			"\t$(SUBMAKE) -f V%s_%dx%d.mk\n",
+			core, Na, Nb, core, Na, Nb, core, Na, Nb);
+	}
+
+	if (lanes < 2)
+		return;
+
+	for(int k=0; k<2; k++) {
+		const char	*core = (k == 0) ? "kumpy" : "ksgnmpy";
+
+		fprintf(fp, "\n");
+		fprintf(fp, ".PHONY: %s_%dx%d\n", core, Na, Nb);
+		fprintf(fp, "%s_%dx%d: $(VDIRFB)/V%s_%dx%d__ALL.a\n",
+			core, Na, Nb, core, Na, Nb);
+		fprintf(fp, "$(VDIRFB)/V%s_%dx%d.h: %s_%dx%d.v %s_%dx%d.v\n",
+			core, Na, Nb, core, Na, Nb, core+1, Na, Nb);
+		fprintf(fp, "$(VDIRFB)/V%s_%dx%d__ALL.a: $(VDIRFB)/V%s_%dx%d.h\n"
+			"\t$(SUBMAKE) -f V%s_%dx%d.mk\n",
+			core, Na, Nb, core, Na, Nb, core, Na, Nb);
+	}
 }
 
 void buildbenchmk(FILE *fp, const char *fname, const int Na, const int Nb,
-		bool async_reset) {
-	fprintf(fp, "test: test%dx%d\n\n", Na, Nb);
-	fprintf(fp, ".PHONY: test%dx%d\n", Na, Nb);
-	fprintf(fp, "MPYS += mpy_tb_%dx%d\n", Na, Nb);
+		bool async_reset, const int lanes,
+		const int nacc, const int nout, const bool cmplx,
+		const int simd, const int ndot) {
+	// Every size is linked into the one mpy_tb, which learns about it
+	// from the mpysizes.h the Makefile builds from MPYSIZES.  mpy_tb (and
+	// mpybench) keep each product in a long, so any wider size would
+	// break the build for all the others, and is left out.
+	if (Na+Nb >= 64) {
+		fprintf(fp, "## No mpy_tb for a %dx%d multiply: its products"
+			" don't fit in 64-bits\n", Na, Nb);
+	} else {
+		fprintf(fp, "test: test%dx%d\n\n", Na, Nb);
+		fprintf(fp, ".PHONY: test%dx%d\n", Na, Nb);
+		fprintf(fp, "MPYSIZES += %dx%d\n", Na, Nb);
+		fprintf(fp,
+"MPYHDRS  += $(RTLOBJD)/Vsgnmpy_%dx%d.h $(RTLOBJD)/Vumpy_%dx%d.h\n"
+"MPYHDRS  += $(RTLD)/sgnmpy_%dx%d.h $(RTLD)/umpy_%dx%d.h\n"
+"MPYHDRS  += $(RTLD)/csgnmpy_%dx%d.h $(RTLD)/cumpy_%dx%d.h\n"
+"MPYLIBS  += $(RTLOBJD)/Vsgnmpy_%dx%d__ALL.a $(RTLOBJD)/Vumpy_%dx%d__ALL.a\n",
+			Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb);
+		fprintf(fp,
+"test%dx%d: mpy_tb\n"
+"\t./mpy_tb --size %dx%d\n",
+			Na, Nb, Na, Nb);
+	}
+
+	if ((lanes > 1)&&(Na+Nb < 64)) {
+		fprintf(fp, "\nMPYS += kmpy_tb_%dx%d\n", Na, Nb);
+		fprintf(fp,
+"$(OBJDIR)/kmpy_tb_%dx%d.o: kmpy_tb.cpp mpycores.h $(RTLD)/sgnmpy_%dx%d.h $(RTLD)/umpy_%dx%d.h\n"
+"$(OBJDIR)/kmpy_tb_%dx%d.o: $(RTLOBJD)/Vksgnmpy_%dx%d.h $(RTLOBJD)/Vkumpy_%dx%d.h\n"
+"\t$(CXX) -DMPYSZ=%dx%d -DKUMPY=Vkumpy_%dx%d -DKSMPY=Vksgnmpy_%dx%d -DNA=%d -DNB=%d -DLANES=%d $(CFLAGS) $(INCS) -c kmpy_tb.cpp -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb, Na, Nb, lanes);
+		fprintf(fp,
+"kmpy_tb_%dx%d: $(OBJDIR)/kmpy_tb_%dx%d.o $(VLOBJS)\n"
+"kmpy_tb_%dx%d: $(RTLOBJD)/Vksgnmpy_%dx%d__ALL.a $(RTLOBJD)/Vkumpy_%dx%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $(OBJDIR)/kmpy_tb_%dx%d.o $(RTLOBJD)/Vksgnmpy_%dx%d__ALL.a $(RTLOBJD)/Vkumpy_%dx%d__ALL.a $(VLOBJS) $(LIBS) -o $@\n",
+			Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb);
+	}
+
+	if ((nacc > 0)&&(nacc <= 64)) {
+		fprintf(fp, "\ntest: testmac_%dx%d\n", Na, Nb);
+		fprintf(fp, "MPYS += mac_tb_%dx%d\n", Na, Nb);
+		fprintf(fp,
+"$(OBJDIR)/mac_tb_%dx%d.o: mac_tb.cpp mpycores.h $(RTLD)/sgnmac_%dx%d.h $(RTLD)/umac_%dx%d.h\n"
+"$(OBJDIR)/mac_tb_%dx%d.o: $(RTLOBJD)/Vsgnmac_%dx%d.h $(RTLOBJD)/Vumac_%dx%d.h\n"
+"\t$(CXX) -DMPYSZ=%dx%d -DUMAC=Vumac_%dx%d -DSMAC=Vsgnmac_%dx%d -DUMACH=umac_%dx%d -DSMACH=sgnmac_%dx%d $(CFLAGS) $(INCS) -c mac_tb.cpp -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp,
+"mac_tb_%dx%d: $(OBJDIR)/mac_tb_%dx%d.o $(VLOBJS)\n"
+"mac_tb_%dx%d: $(RTLOBJD)/Vsgnmac_%dx%d__ALL.a $(RTLOBJD)/Vumac_%dx%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $(OBJDIR)/mac_tb_%dx%d.o $(RTLOBJD)/Vsgnmac_%dx%d__ALL.a $(RTLOBJD)/Vumac_%dx%d__ALL.a $(VLOBJS) $(LIBS) -o $@\n",
+			Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp, ".PHONY: testmac_%dx%d\n"
+"testmac_%dx%d: mac_tb_%dx%d\n"
+"\t./mac_tb_%dx%d\n", Na, Nb, Na, Nb, Na, Nb, Na, Nb);
+	}
+
+	if (nout > 0) {
+		fprintf(fp, "\ntest: testtrunc_%dx%d\n", Na, Nb);
+		fprintf(fp, "MPYS += trunc_tb_%dx%d\n", Na, Nb);
+		fprintf(fp,
+"$(OBJDIR)/trunc_tb_%dx%d.o: trunc_tb.cpp mpycores.h $(RTLD)/sgnmpyhi_%dx%d.h $(RTLD)/umpyhi_%dx%d.h\n"
+"$(OBJDIR)/trunc_tb_%dx%d.o: $(RTLOBJD)/Vsgnmpyhi_%dx%d.h $(RTLOBJD)/Vumpyhi_%dx%d.h\n"
+"\t$(CXX) -DMPYSZ=%dx%d -DUHI=Vumpyhi_%dx%d -DSHI=Vsgnmpyhi_%dx%d -DUHIH=umpyhi_%dx%d -DSHIH=sgnmpyhi_%dx%d $(CFLAGS) $(INCS) -c trunc_tb.cpp -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp,
+"trunc_tb_%dx%d: $(OBJDIR)/trunc_tb_%dx%d.o $(VLOBJS)\n"
+"trunc_tb_%dx%d: $(RTLOBJD)/Vsgnmpyhi_%dx%d__ALL.a $(RTLOBJD)/Vumpyhi_%dx%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $(OBJDIR)/trunc_tb_%dx%d.o $(RTLOBJD)/Vsgnmpyhi_%dx%d__ALL.a $(RTLOBJD)/Vumpyhi_%dx%d__ALL.a $(VLOBJS) $(LIBS) -o $@\n",
+			Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp, ".PHONY: testtrunc_%dx%d\n"
+"testtrunc_%dx%d: trunc_tb_%dx%d\n"
+"\t./trunc_tb_%dx%d\n", Na, Nb, Na, Nb, Na, Nb, Na, Nb);
+	}
+
+	if ((cmplx)&&(Na+Nb+1 < 64)) {
+		fprintf(fp, "\ntest: testcmplx_%dx%d\n", Na, Nb);
+		fprintf(fp, "MPYS += cmplx_tb_%dx%d\n", Na, Nb);
+		fprintf(fp,
+"$(OBJDIR)/cmplx_tb_%dx%d.o: cmplx_tb.cpp mpycores.h $(RTLD)/cmplx_%dx%d.h $(RTLOBJD)/Vcmplx_%dx%d.h\n"
+"\t$(CXX) -DMPYSZ=%dx%d -DCMPLX=Vcmplx_%dx%d -DCMPLXH=cmplx_%dx%d $(CFLAGS) $(INCS) -c cmplx_tb.cpp -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp,
+"cmplx_tb_%dx%d: $(OBJDIR)/cmplx_tb_%dx%d.o $(VLOBJS) $(RTLOBJD)/Vcmplx_%dx%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $^ $(LIBS) -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp, ".PHONY: testcmplx_%dx%d\n"
+"testcmplx_%dx%d: cmplx_tb_%dx%d\n"
+"\t./cmplx_tb_%dx%d\n", Na, Nb, Na, Nb, Na, Nb, Na, Nb);
+	}
+
+	if ((simd > 0)&&(Na+Nb <= 64)) {
+		fprintf(fp, "\ntest: testsimd_%dx%d\n", Na, Nb);
+		fprintf(fp, "MPYS += simd_tb_%dx%d\n", Na, Nb);
+		fprintf(fp,
+"$(OBJDIR)/simd_tb_%dx%d.o: simd_tb.cpp mpycores.h $(RTLD)/usimd_%dx%d.h $(RTLOBJD)/Vusimd_%dx%d.h\n"
+"\t$(CXX) -DMPYSZ=%dx%d -DSIMD=Vusimd_%dx%d -DSIMDH=usimd_%dx%d $(CFLAGS) $(INCS) -c simd_tb.cpp -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb,
+			Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp,
+"simd_tb_%dx%d: $(OBJDIR)/simd_tb_%dx%d.o $(VLOBJS) $(RTLOBJD)/Vusimd_%dx%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $^ $(LIBS) -o $@\n",
+			Na, Nb, Na, Nb, Na, Nb);
+		fprintf(fp, ".PHONY: testsimd_%dx%d\n"
+"testsimd_%dx%d: simd_tb_%dx%d\n"
+"\t./simd_tb_%dx%d\n", Na, Nb, Na, Nb, Na, Nb, Na, Nb);
+	}
+
+	if ((ndot > 0)&&(dotbits(ndot, Na, Nb) < 64)) {
+		fprintf(fp, "\ntest: testdot_%d_%dx%d\n", ndot, Na, Nb);
+		fprintf(fp, "MPYS += dot_tb_%d_%dx%d\n", ndot, Na, Nb);
+		fprintf(fp,
+"$(OBJDIR)/dot_tb_%d_%dx%d.o: dot_tb.cpp mpycores.h $(RTLD)/sgndot%d_%dx%d.h $(RTLD)/udot%d_%dx%d.h\n"
+"$(OBJDIR)/dot_tb_%d_%dx%d.o: $(RTLOBJD)/Vsgndot%d_%dx%d.h $(RTLOBJD)/Vudot%d_%dx%d.h\n"
+"\t$(CXX) -DDOTSZ=%d_%dx%d -DUDP=Vudot%d_%dx%d -DSDP=Vsgndot%d_%dx%d -DUDPH=udot%d_%dx%d -DSDPH=sgndot%d_%dx%d $(CFLAGS) $(INCS) -c dot_tb.cpp -o $@\n",
+			ndot, Na, Nb, ndot, Na, Nb, ndot, Na, Nb,
+			ndot, Na, Nb, ndot, Na, Nb, ndot, Na, Nb,
+			ndot, Na, Nb, ndot, Na, Nb, ndot, Na, Nb,
+			ndot, Na, Nb, ndot, Na, Nb);
+		fprintf(fp,
+"dot_tb_%d_%dx%d: $(OBJDIR)/dot_tb_%d_%dx%d.o $(VLOBJS)\n"
+"dot_tb_%d_%dx%d: $(RTLOBJD)/Vsgndot%d_%dx%d__ALL.a $(RTLOBJD)/Vudot%d_%dx%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $(OBJDIR)/dot_tb_%d_%dx%d.o $(RTLOBJD)/Vsgndot%d_%dx%d__ALL.a $(RTLOBJD)/Vudot%d_%dx%d__ALL.a $(VLOBJS) $(LIBS) -o $@\n",
+			ndot, Na, Nb, ndot, Na, Nb,
+			ndot, Na, Nb, ndot, Na, Nb, ndot, Na, Nb,
+			ndot, Na, Nb, ndot, Na, Nb, ndot, Na, Nb);
+		fprintf(fp, ".PHONY: testdot_%d_%dx%d\n"
+"testdot_%d_%dx%d: dot_tb_%d_%dx%d\n"
+"\t./dot_tb_%d_%dx%d\n", ndot, Na, Nb, ndot, Na, Nb, ndot, Na, Nb,
+			ndot, Na, Nb);
+	}
+}
+
+//
+// buildpremulmk
+//
+// Writes the rules for premul_tb_N, the exhaustive test of the premulN
+// sub-multiplier.  bimpy has none, since its FORMAL properties are the ones
+// that have always been proven.
+//
+void	buildpremulmk(FILE *fp, const int premul, const bool async_reset) {
+	fprintf(fp, "test: testpremul%d\n\n", premul);
+	fprintf(fp, "MPYS += premul_tb_%d\n", premul);
 	fprintf(fp,
-"$(OBJDIR)/mpy_tb_%dx%d.o: mpy_tb.cpp components.h\n"
-"$(OBJDIR)/mpy_tb_%dx%d.o: $(RTLOBJD)/Vsgnmpy_%dx%d.h\n"
-"$(OBJDIR)/mpy_tb_%dx%d.o: $(RTLOBJD)/Vumpy_%dx%d.h\n"
-"\t$(CXX) -DMPYSZ=%dx%d -DUMPY=Vumpy_%dx%d -DSMPY=Vsgnmpy_%dx%d -DNA=%d -DNB=%d %s $(CFLAGS) $(INCS) -c mpy_tb.cpp -o $@\n",
-	Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb, Na, Nb,
-	Na, Nb, Na, Nb, (async_reset)?"-DASYNC":"");
+"$(OBJDIR)/premul_tb_%d.o: premul_tb.cpp mpycores.h $(RTLOBJD)/Vpremul%d.h\n"
+"\t$(CXX) -DPREMUL=Vpremul%d -DLUTB=%d -DASYNC_RESET=%d $(CFLAGS) $(INCS) -c premul_tb.cpp -o $@\n"
+"premul_tb_%d: $(OBJDIR)/premul_tb_%d.o $(VLOBJS) $(RTLOBJD)/Vpremul%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $^ $(LIBS) -o $@\n",
+		premul, premul, premul, premul, (async_reset)?1:0,
+		premul, premul, premul);
+	fprintf(fp, "\n.PHONY: testpremul%d\n"
+"testpremul%d: premul_tb_%d\n"
+"\t./premul_tb_%d\n", premul, premul, premul, premul);
+}
 
-	fprintf(fp, 
-"mpy_tb_%dx%d: $(RTLOBJD)/Vsgnmpy_%dx%d__ALL.a\n"
-"mpy_tb_%dx%d: $(RTLOBJD)/Vumpy_%dx%d__ALL.a\n"
-"mpy_tb_%dx%d: $(OBJDIR)/mpy_tb_%dx%d.o $(VLOBJS)\n"
-"\t$(CXX) $(CFLAGS) $(INCS) $(OBJDIR)/mpy_tb_%dx%d.o $(RTLOBJD)/Vsgnmpy_%dx%d__ALL.a $(RTLOBJD)/Vumpy_%dx%d__ALL.a $(VLOBJS) -o $@\n",
-		Na, Nb,
-		Na, Nb,
-		Na, Nb,
-		Na, Nb,
-		Na, Nb,
-		Na, Nb,
-		Na, Nb,
-		Na, Nb,
-		Na, Nb);
-	fprintf(fp,
-"test%dx%d: mpy_tb_%dx%d\n"
-"\tmpy_tb_%dx%d\n",
-		Na, Nb, Na, Nb, Na, Nb);
+//
+// buildconstmk
+//
+// Writes the rules for constmpy_tb_<name>, the exhaustive test of a
+// constant multiply core.
+//
+void	buildconstmk(FILE *fp, const char *name) {
+	std::string	prefix = name;
+
+	for(unsigned k=0; k<prefix.size() && prefix[k] != '_'; k++)
+		prefix[k] = toupper(prefix[k]);
+
+	fprintf(fp, "test: testconst_%s\n\n", name);
+	fprintf(fp, "MPYS += constmpy_tb_%s\n", name);
+	fprintf(fp,
+"$(OBJDIR)/constmpy_tb_%s.o: constmpy_tb.cpp mpycores.h $(RTLOBJD)/V%s.h $(RTLD)/%s.h\n"
+"\t$(CXX) -DCMPY=V%s -DCMPYH=%s -DCMPYD=%s $(CFLAGS) $(INCS) -c constmpy_tb.cpp -o $@\n"
+"constmpy_tb_%s: $(OBJDIR)/constmpy_tb_%s.o $(VLOBJS) $(RTLOBJD)/V%s__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $^ $(LIBS) -o $@\n",
+		name, name, name,
+		name, name, prefix.c_str(),
+		name, name, name);
+	fprintf(fp, "\n.PHONY: testconst_%s\n"
+"testconst_%s: constmpy_tb_%s\n"
+"\t./constmpy_tb_%s\n", name, name, name, name);
+}
+
+//
+// buildsqrmk
+//
+// Writes the rules for sqr_tb_<n>, the exhaustive test of both squaring
+// cores.
+//
+void	buildsqrmk(FILE *fp, const int n) {
+	fprintf(fp, "test: testsqr_%d\n\n", n);
+	fprintf(fp, "MPYS += sqr_tb_%d\n", n);
+	fprintf(fp,
+"$(OBJDIR)/sqr_tb_%d.o: sqr_tb.cpp mpycores.h $(RTLD)/sgnsqr_%d.h $(RTLD)/usqr_%d.h\n"
+"$(OBJDIR)/sqr_tb_%d.o: $(RTLOBJD)/Vsgnsqr_%d.h $(RTLOBJD)/Vusqr_%d.h\n"
+"\t$(CXX) -DSQRSZ=%d -DUSQR=Vusqr_%d -DSSQR=Vsgnsqr_%d -DUSQRH=usqr_%d -DSSQRH=sgnsqr_%d $(CFLAGS) $(INCS) -c sqr_tb.cpp -o $@\n",
+		n, n, n, n, n, n, n, n, n, n, n);
+	fprintf(fp,
+"sqr_tb_%d: $(OBJDIR)/sqr_tb_%d.o $(VLOBJS)\n"
+"sqr_tb_%d: $(RTLOBJD)/Vsgnsqr_%d__ALL.a $(RTLOBJD)/Vusqr_%d__ALL.a\n"
+"\t$(CXX) $(CFLAGS) $(INCS) $(OBJDIR)/sqr_tb_%d.o $(RTLOBJD)/Vsgnsqr_%d__ALL.a $(RTLOBJD)/Vusqr_%d__ALL.a $(VLOBJS) $(LIBS) -o $@\n",
+		n, n, n, n, n, n, n, n);
+	fprintf(fp, "\n.PHONY: testsqr_%d\n"
+"testsqr_%d: sqr_tb_%d\n"
+"\t./sqr_tb_%d\n", n, n, n, n);
 }
 
 bool	direxists(const char *) {
 	return true;
 }
 
-void	buildmpy(const char *dir, int premul, int Na, int Nb, bool use_aux, bool async_reset) {
+void	buildmpy(const char *dir, int premul, int Na, int Nb, bool use_aux, bool async_reset, bool bitslice, int lanes) {
 	FILE	*fp;
 	char	fname[256];
 
@@ -814,7 +5423,13 @@ void	buildmpy(const char *dir, int premul, int Na, int Nb, bool use_aux, bool as
 	} else if (verbose_flag) {
 		fprintf(stderr, "Writing %s\n", fname);
 	} sprintf(fname, "sgnmpy_%dx%d", Na, Nb);
-	buildsmpy(fp, fname, premul, Na, Nb, use_aux, async_reset);
+	if (booth_flag)
+		buildboothmpy(fp, fname, Na, Nb, use_aux, async_reset);
+	else if (bw_flag)
+		buildumpy(fp, fname, premul, Na, Nb, true, use_aux,
+			async_reset);
+	else
+		buildsmpy(fp, fname, premul, Na, Nb, use_aux, async_reset);
 	fclose(fp);
 
 	if (dir)
@@ -829,9 +5444,214 @@ void	buildmpy(const char *dir, int premul, int Na, int Nb, bool use_aux, bool as
 	} else if (verbose_flag) {
 		fprintf(stderr, "Writing %s\n", fname);
 	} sprintf(fname, "umpy_%dx%d", Na, Nb);
-	buildumpy(fp, fname, premul, Na, Nb, use_aux, async_reset);
+	buildumpy(fp, fname, premul, Na, Nb, false, use_aux, async_reset);
 	fclose(fp);
 
+	// A tiled umpy needs its sub-cores, each of which may itself be
+	// (Karatsuba) tiled
+	{
+		const std::vector<int>	sizes = subcores(Na, Nb);
+
+		for(unsigned k=0; k<sizes.size(); k++) {
+			sprintf(fname, "umpy_%dx%d.v", sizes[k], sizes[k]);
+			fp = openout(dir, fname);
+			sprintf(fname, "umpy_%dx%d", sizes[k], sizes[k]);
+			buildumpy(fp, fname, premul, sizes[k], sizes[k], false,
+				use_aux, async_reset);
+			fclose(fp);
+		}
+	}
+
+	{
+		FILE	*hp, *jp;
+		const char	*cores[2] = { "umpy", "sgnmpy" };
+
+		for(int k=0; k<2; k++) {
+			sprintf(fname, "%s_%dx%d.h", cores[k], Na, Nb);
+			hp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d.json", cores[k], Na, Nb);
+			jp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d", cores[k], Na, Nb);
+			builddesc(hp, jp, fname, premul, Na, Nb, (k != 0),
+				use_aux, async_reset);
+			fclose(hp);
+			fclose(jp);
+		}
+	}
+
+	if (mac_width > 0) {
+		FILE	*hp, *jp;
+		const char	*cores[2] = { "umac", "sgnmac" };
+
+		for(int k=0; k<2; k++) {
+			sprintf(fname, "%s_%dx%d.v", cores[k], Na, Nb);
+			fp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d.h", cores[k], Na, Nb);
+			hp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d.json", cores[k], Na, Nb);
+			jp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d", cores[k], Na, Nb);
+			buildmac(fp, fname, premul, Na, Nb, mac_width, (k != 0),
+				use_aux, async_reset);
+			buildmacdesc(hp, jp, fname, premul, Na, Nb, mac_width,
+				(k != 0), use_aux, async_reset);
+			fclose(fp);
+			fclose(hp);
+			fclose(jp);
+		}
+	}
+
+	if (out_bits > 0) {
+		FILE	*hp, *jp;
+		const char	*cores[2] = { "umpyhi", "sgnmpyhi" };
+
+		for(int k=0; k<2; k++) {
+			sprintf(fname, "%s_%dx%d.v", cores[k], Na, Nb);
+			fp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d.h", cores[k], Na, Nb);
+			hp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d.json", cores[k], Na, Nb);
+			jp = openout(dir, fname);
+			sprintf(fname, "%s_%dx%d", cores[k], Na, Nb);
+			buildtruncmpy(fp, fname, premul, Na, Nb, out_bits,
+				(k != 0), use_aux, async_reset);
+			buildtruncdesc(hp, jp, fname, premul, Na, Nb, out_bits,
+				(k != 0), use_aux, async_reset);
+			fclose(fp);
+			fclose(hp);
+			fclose(jp);
+		}
+	}
+
+	if (cmplx_flag) {
+		FILE	*hp, *jp;
+		// The signed sub-cores, narrowest operand first, and the
+		// unsigned cores within them
+		const int	sizes[2][2] = {
+				{ std::min(Na+1, Nb), std::max(Na+1, Nb) },
+				{ std::min(Nb+1, Na), std::max(Nb+1, Na) } };
+
+		for(int k=0; k<2; k++) {
+			const int	sa = sizes[k][0], sb = sizes[k][1];
+
+			if ((k > 0)&&(sa == sizes[0][0])&&(sb == sizes[0][1]))
+				break;
+			sprintf(fname, "sgnmpy_%dx%d.v", sa, sb);
+			fp = openout(dir, fname);
+			sprintf(fname, "sgnmpy_%dx%d", sa, sb);
+			if (booth_flag)
+				buildboothmpy(fp, fname, sa, sb, use_aux,
+					async_reset);
+			else if (bw_flag)
+				buildumpy(fp, fname, premul, sa, sb, true,
+					use_aux, async_reset);
+			else
+				buildsmpy(fp, fname, premul, sa, sb, use_aux,
+					async_reset);
+			fclose(fp);
+
+			if ((booth_flag)||(bw_flag))
+				continue;
+			sprintf(fname, "umpy_%dx%d.v", sa, sb);
+			fp = openout(dir, fname);
+			sprintf(fname, "umpy_%dx%d", sa, sb);
+			buildumpy(fp, fname, premul, sa, sb, false, use_aux,
+				async_reset);
+			fclose(fp);
+		}
+
+		sprintf(fname, "cmplx_%dx%d.v", Na, Nb);
+		fp = openout(dir, fname);
+		sprintf(fname, "cmplx_%dx%d.h", Na, Nb);
+		hp = openout(dir, fname);
+		sprintf(fname, "cmplx_%dx%d.json", Na, Nb);
+		jp = openout(dir, fname);
+		sprintf(fname, "cmplx_%dx%d", Na, Nb);
+		buildcmplx(fp, fname, premul, Na, Nb, use_aux, async_reset);
+		buildcmplxdesc(hp, jp, fname, premul, Na, Nb, use_aux,
+			async_reset);
+		fclose(fp);
+		fclose(hp);
+		fclose(jp);
+	}
+
+	if (simd_width > 0) {
+		FILE	*hp, *jp;
+
+		sprintf(fname, "usimd_%dx%d.v", Na, Nb);
+		fp = openout(dir, fname);
+		sprintf(fname, "usimd_%dx%d.h", Na, Nb);
+		hp = openout(dir, fname);
+		sprintf(fname, "usimd_%dx%d.json", Na, Nb);
+		jp = openout(dir, fname);
+		sprintf(fname, "usimd_%dx%d", Na, Nb);
+		buildsimd(fp, fname, premul, Na, simd_width, use_aux,
+			async_reset);
+		buildsimddesc(hp, jp, fname, premul, Na, simd_width, use_aux,
+			async_reset);
+		fclose(fp);
+		fclose(hp);
+		fclose(jp);
+	}
+
+	for(int k=0; (dot_count > 0)&&(k<2); k++) {
+		FILE	*hp, *jp;
+		char	core[64];
+
+		sprintf(core, "%sdot%d_%dx%d", (k == 0) ? "u" : "sgn",
+			dot_count, Na, Nb);
+		sprintf(fname, "%s.v", core);
+		fp = openout(dir, fname);
+		sprintf(fname, "%s.h", core);
+		hp = openout(dir, fname);
+		sprintf(fname, "%s.json", core);
+		jp = openout(dir, fname);
+		builddot(fp, core, premul, dot_count, Na, Nb, (k != 0),
+			use_aux, async_reset);
+		builddotdesc(hp, jp, core, premul, dot_count, Na, Nb, (k != 0),
+			use_aux, async_reset);
+		fclose(fp);
+		fclose(hp);
+		fclose(jp);
+	}
+
+	if (Na+Nb <= 64) {
+		const char	*cores[2] = { "cumpy", "csgnmpy" };
+
+		for(int k=0; k<2; k++) {
+			sprintf(fname, "%s_%dx%d.h", cores[k], Na, Nb);
+			fp = openout(dir, fname);
+			sprintf(fname, "C%s_%dx%d", cores[k]+1, Na, Nb);
+			buildcmpy(fp, fname, premul, Na, Nb, (k != 0),
+				use_aux, async_reset);
+			fclose(fp);
+		}
+	} else
+		fprintf(stderr, "WARNING: No C++ models for products wider than 64-bits\n");
+
+	if (bitslice) {
+		sprintf(fname, "bsmpy_%dx%d.h", Na, Nb);
+		fp = openout(dir, fname);
+		sprintf(fname, "bsmpy_%dx%d", Na, Nb);
+		buildbsmpy(fp, fname, premul, Na, Nb);
+		fclose(fp);
+	}
+
+	if (lanes > 1) {
+		const char	*cores[2] = { "umpy", "sgnmpy" };
+		char		core[64];
+
+		for(int k=0; k<2; k++) {
+			sprintf(fname, "k%s_%dx%d.v", cores[k], Na, Nb);
+			fp = openout(dir, fname);
+			sprintf(fname, "k%s_%dx%d", cores[k], Na, Nb);
+			sprintf(core, "%s_%dx%d", cores[k], Na, Nb);
+			buildlanes(fp, fname, core, Na, Nb, lanes,
+				use_aux, async_reset);
+			fclose(fp);
+		}
+	}
+
 	if (premul == 2) {
 		if (dir)
 			sprintf(fname, "%s/bimpy.v", dir);
@@ -869,7 +5689,8 @@ void	buildmpy(const char *dir, int premul, int Na, int Nb, bool use_aux, bool as
 	} else if (verbose_flag) {
 		fprintf(stderr, "Writing %s\n", fname);
 	}
-	buildmakinc(fp, fname, Na, Nb);
+	buildmakinc(fp, fname, Na, Nb, lanes, mac_width, out_bits, cmplx_flag,
+		simd_width, dot_count);
 	fclose(fp);
 
 	if (direxists("../bench/cpp"))
@@ -884,48 +5705,434 @@ void	buildmpy(const char *dir, int premul, int Na, int Nb, bool use_aux, bool as
 	} else if (verbose_flag) {
 		fprintf(stderr, "Writing %s\n", fname);
 	}
-	buildbenchmk(fp, fname, Na, Nb, async_reset);
+	buildbenchmk(fp, fname, Na, Nb, async_reset, lanes,
+		mac_width, out_bits, cmplx_flag, simd_width, dot_count);
+	fclose(fp);
+
+	if (premul > 2) {
+		if (direxists("../bench/cpp"))
+			sprintf(fname, "../bench/cpp/mkpremul%d.mk", premul);
+		else
+			sprintf(fname, "mkpremul%d.mk", premul);
+		fp = fopen(fname, "w");
+		if (!fp) {
+			fprintf(stderr, "Could not open %s for writing\n", fname);
+			perror("O/S Err:");
+			exit(EXIT_FAILURE);
+		} else if (verbose_flag) {
+			fprintf(stderr, "Writing %s\n", fname);
+		}
+		buildpremulmk(fp, premul, async_reset);
+		fclose(fp);
+	}
+}
+
+void	buildconst(const char *dir, const char *name, const int na,
+		const std::vector<long> &coefs, bool use_aux,
+		bool async_reset) {
+	FILE	*fp, *jp;
+	std::string	fname;
+
+	if (verbose_flag)
+		printf("Building a %d-bit multiply by %d constant%s\n", na,
+			(int)coefs.size(), (coefs.size() > 1) ? "s":"");
+
+	fname = std::string(name) + ".v";
+	fp = openout(dir, fname.c_str());
+	buildconstmpy(fp, name, na, coefs, use_aux, async_reset);
+	fclose(fp);
+
+	fname = std::string(name) + ".h";
+	fp = openout(dir, fname.c_str());
+	fname = std::string(name) + ".json";
+	jp = openout(dir, fname.c_str());
+	buildconstdesc(fp, jp, name, na, coefs, use_aux, async_reset);
+	fclose(fp);
+	fclose(jp);
+
+	fname = std::string("mkconst_") + name + ".mk";
+	if (direxists("../bench/cpp"))
+		fp = openout("../bench/cpp", fname.c_str());
+	else
+		fp = openout(NULL, fname.c_str());
+	buildconstmk(fp, name);
+	fclose(fp);
+}
+
+void	buildsquare(const char *dir, const int premul, const int n,
+		bool use_aux, bool async_reset) {
+	FILE	*fp, *jp;
+	char	fname[256];
+
+	if (verbose_flag)
+		printf("Building a %d-bit square\n", n);
+
+	for(int k=0; k<2; k++) {
+		const char	*core = (k == 0) ? "usqr" : "sgnsqr";
+
+		sprintf(fname, "%s_%d.v", core, n);
+		fp = openout(dir, fname);
+		sprintf(fname, "%s_%d", core, n);
+		buildsqr(fp, fname, premul, n, (k != 0), use_aux,
+			async_reset);
+		fclose(fp);
+
+		sprintf(fname, "%s_%d.h", core, n);
+		fp = openout(dir, fname);
+		sprintf(fname, "%s_%d.json", core, n);
+		jp = openout(dir, fname);
+		sprintf(fname, "%s_%d", core, n);
+		buildsqrdesc(fp, jp, fname, premul, n, (k != 0), use_aux,
+			async_reset);
+		fclose(fp);
+		fclose(jp);
+	}
+
+	sprintf(fname, "mksqr%d.mk", n);
+	if (direxists("../bench/cpp"))
+		fp = openout("../bench/cpp", fname);
+	else
+		fp = openout(NULL, fname);
+	buildsqrmk(fp, n);
 	fclose(fp);
 }
 
 void	usage(void) {
-	printf("USAGE: bldmpy [-d dir] [-n name] <#-of-bits-in-A> <#-of-bits-in-B>\n");
+	printf("USAGE: bldmpy [-d dir] [-n name] [-b|-w] [-c layers] [-l clocks] [-m bits] [--target lut4|lut6] [-t bits [--karatsuba]] [--dsp AxB] [--mac bits] [--out-bits bits [--round] [--var-comp]] [--complex] [--simd bits] [--dot count] [-s] [-k lanes] <#-of-bits-in-A> <#-of-bits-in-B>\n"
+"       bldmpy [-d dir] [-n name] --const C[,C...] <#-of-bits-in-A>\n"
+"       bldmpy [-d dir] [-c layers] [-m bits] --square <#-of-bits-in-A>\n"
+"\t-b\tBuild the signed core from radix-4 Booth encoded rows, rather\n"
+"\t\tthan by negating into and out of the unsigned core\n"
+"\t-w\tBuild the signed core from Baugh-Wooley sign corrected rows,\n"
+"\t\tadded together just as the unsigned core\'s are\n"
+"\t-c\tReduce the partial products with layers of carry-save\n"
+"\t\tcompressors, registering every this many layers, followed by\n"
+"\t\ta single adder, rather than with a tree of adders\n"
+"\t-l\tRegister only this many of each core\'s stages, spread evenly\n"
+"\t\tacross them, for a latency of this many clocks.  Zero builds\n"
+"\t\tcores without any registers at all\n"
+"\t-m\tBuild the tableau from this many bits of the smaller operand\n"
+"\t\tper row, using bimpy (2), premul3 (3), or premul4 (4)\n"
+"\t--target\tPick -m to suit 4-input (lut4), or 6-input (lut6), LUTs\n"
+"\t-t\tBuild the unsigned core from umpy cores of this many bits\n"
+"\t\tsquare, one for each pair of tiles, rather than as one tableau\n"
+"\t--karatsuba\tCombine three half-sized cores in place of four,\n"
+"\t\trecursively, until each fits a -t tile\n"
+"\t--dsp\tBuild the unsigned core around as many hard multipliers of\n"
+"\t\tthis shape (such as 18x25) as fit, with LUTs for the rest\n"
+"\t--mac\tAlso write umac_AxB.v and sgnmac_AxB.v, multiply-accumulate\n"
+"\t\tcores with an accumulator of this many bits\n"
+"\t--out-bits\tAlso write umpyhi_AxB.v and sgnmpyhi_AxB.v, giving only\n"
+"\t\tthis many of the top bits of the product, from a tableau missing\n"
+"\t\tits lowest columns\n"
+"\t--round\tRound those products to the nearest, rather than down\n"
+"\t--var-comp\tMake up for the missing columns with the bits of the\n"
+"\t\thighest of them, rather than with a constant alone\n"
+"\t--complex\tAlso write cmplx_AxB.v, a complex multiply of two signed\n"
+"\t\tparts apiece, from three of the signed cores\n"
+"\t--simd\tAlso write usimd_AxA.v, an unsigned multiply that i_mode can\n"
+"\t\tsplit into packed lanes, halving them down to this many bits\n"
+"\t--dot\tAlso write udotN_AxB.v and sgndotN_AxB.v, adding this many\n"
+"\t\tproducts together in the one adder tree\n"
+"\t-s\tAlso write a bit-sliced C++ model, bsmpy_AxB.h, for bsmpy_tb\n"
+"\t-k\tAlso write kumpy_AxB.v and ksgnmpy_AxB.v, holding this many\n"
+"\t\tcopies of each core side by side, for kmpy_tb\n"
+"\t--const\tBuild a core, named by -n (constmpy by default), multiplying\n"
+"\t\ti_a by each of these signed constants with shifts and adds\n"
+"\t--square\tBuild usqr_A.v and sgnsqr_A.v, squaring i_a, from a\n"
+"\t\ttableau holding each product of two different bits only once\n");
 }
 
 int main(int argc, char **argv) {
 	bool	use_aux = true;
-	bool	async_reset = false;
-	int	premul = 2;
-	const char	*core_dir = "../rtl";
-			// *core_name = NULL;
+	bool	async_reset = false, bitslice = false, square = false;
+	int	premul = 0, lanes = 0;
+	const char	*target = "lut4";
+	const char	*core_dir = "../rtl",
+			*core_name = NULL;
+	std::vector<long>	coefs;
 	int	na, nb;
 
 	{ int c;
-        while((c = getopt(argc, argv, "d:n:aA")) != -1) {
+	static const struct option	longopts[] = {
+		{ "target", required_argument, NULL, 'T' },
+		{ "karatsuba", no_argument, NULL, 'K' },
+		{ "dsp", required_argument, NULL, 'D' },
+		{ "const", required_argument, NULL, 'C' },
+		{ "mac", required_argument, NULL, 'M' },
+		{ "out-bits", required_argument, NULL, 'O' },
+		{ "round", no_argument, NULL, 'U' },
+		{ "var-comp", no_argument, NULL, 'V' },
+		{ "square", no_argument, NULL, 'Q' },
+		{ "complex", no_argument, NULL, 'X' },
+		{ "simd", required_argument, NULL, 'I' },
+		{ "dot", required_argument, NULL, 'P' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+        while((c = getopt_long(argc, argv, "bc:d:k:l:m:n:t:aArRsw",
+				longopts, NULL)) != -1) {
                 switch(c) {
+                case 'b':	booth_flag = true;   break;
+                case 'w':	bw_flag = true;      break;
+                case 'c':	csa_layers = atoi(optarg); break;
                 case 'a':	use_aux = true;      break;
                 case 'A':	use_aux = false;     break;
                 case 'r':	async_reset = true;  break;
                 case 'R':	async_reset = false; break;
+                case 's':	bitslice = true;     break;
                 case 'd':	core_dir  = strdup(optarg); break;
-                case 'n':	break; // core_name = strdup(optarg); break;
+                case 'k':	lanes = atoi(optarg); break;
+                case 'l':	latency_budget = atoi(optarg);
+			if (latency_budget < 0) {
+				fprintf(stderr, "ERR: A core can\'t have a negative latency\n");
+				exit(EXIT_FAILURE);
+			} break;
+                case 'm':	premul = atoi(optarg); break;
+                case 'n':	core_name = strdup(optarg); break;
+                case 't':	tile_size = atoi(optarg); break;
+                case 'T':	target = strdup(optarg); break;
+                case 'K':	karatsuba_flag = true; break;
+                case 'M':	mac_width = atoi(optarg); break;
+                case 'O':	out_bits = atoi(optarg); break;
+                case 'U':	round_flag = true; break;
+                case 'V':	varcomp_flag = true; break;
+                case 'Q':	square = true; break;
+                case 'X':	cmplx_flag = true; break;
+                case 'I':	simd_width = atoi(optarg); break;
+                case 'P':	dot_count = atoi(optarg); break;
+                case 'D':	if ((sscanf(optarg, "%dx%d", &dsp_na, &dsp_nb) != 2)
+					||(dsp_na < 1)||(dsp_nb < 1)) {
+				fprintf(stderr, "ERR: Bad hard multiplier shape, %s.  Try 18x25\n", optarg);
+				exit(EXIT_FAILURE);
+			} break;
+                case 'C':	{ char *ptr = optarg, *end;
+			do {
+				coefs.push_back(strtol(ptr, &end, 0));
+				if ((end == ptr)||((*end != ',')&&(*end != '\0'))) {
+					fprintf(stderr, "ERR: Bad constant list, %s\n", optarg);
+					exit(EXIT_FAILURE);
+				} ptr = end+1;
+			} while(*end == ',');
+			} break;
 		default:
 			break;
 		}
 	}}
 
-	if (argc -optind != 2) {
+	if (coefs.size() > 0) {
+		if (argc -optind != 1) {
+			usage();
+			exit(EXIT_FAILURE);
+		} else if ((booth_flag)||(bw_flag)||(csa_layers != 0)
+				||(latency_budget >= 0)||(tile_size != 0)
+				||(dsp_na > 0)||(lanes != 0)||(bitslice)
+				||(mac_width != 0)||(out_bits != 0)||(square)
+				||(cmplx_flag)||(simd_width != 0)
+				||(dot_count != 0)) {
+			fprintf(stderr, "ERR: A constant multiply (--const) is built from shifts and\n"
+				"\tadds alone, and takes none of -b, -w, -c, -l, -t, --dsp,\n"
+				"\t--mac, --out-bits, --square, --complex, --simd, --dot, -k,\n"
+				"\tor -s\n");
+			exit(EXIT_FAILURE);
+		}
+
+		na = atoi(argv[optind]);
+		if ((na < 2)||(na + constbits(coefs) >= 64)) {
+			fprintf(stderr, "ERR: A constant multiply needs at least two bits of\n"
+				"\ti_a, and fewer than 64 bits in each product\n");
+			exit(EXIT_FAILURE);
+		}
+
+		// components.h takes anything named *mpy_* for one of
+		// the general cores
+		if (!core_name)
+			core_name = "constmpy";
+		else if (strstr(core_name, "mpy_")) {
+			fprintf(stderr, "ERR: %s would be mistaken for a umpy or sgnmpy core\n", core_name);
+			exit(EXIT_FAILURE);
+		}
+
+		buildconst(core_dir, core_name, na, coefs, use_aux,
+			async_reset);
+		return(0);
+	}
+
+	if (argc -optind != ((square) ? 1 : 2)) {
 		usage();
 		exit(EXIT_FAILURE);
 	}
-	if (premul != 2) {
-		fprintf(stderr, "WARNING: The bimpy pre-multiply is the only one that has been proven\n");
+	// Every bit of bimpy's product depends upon four inputs, two from
+	// each operand, and every bit of premul3's upon six.  An explicit -m
+	// overrides the target.
+	if ((strcmp(target, "lut4") != 0)&&(strcmp(target, "lut6") != 0)) {
+		fprintf(stderr, "ERR: Unknown target, %s.  Try lut4 or lut6\n", target);
+		exit(EXIT_FAILURE);
+	}
+
+	if (premul == 0)
+		premul = (strcmp(target, "lut6") == 0) ? 3 : 2;
+	else if ((premul < 2)||(premul > 4)) {
+		fprintf(stderr, "ERR: Only 2, 3, or 4-bit pre-multiplies are supported\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (square) {
+		if ((booth_flag)||(bw_flag)||(latency_budget >= 0)
+				||(tile_size != 0)||(dsp_na > 0)||(lanes != 0)
+				||(bitslice)||(mac_width != 0)||(out_bits != 0)
+				||(round_flag)||(varcomp_flag)||(core_name)
+				||(cmplx_flag)||(simd_width != 0)
+				||(dot_count != 0)) {
+			fprintf(stderr, "ERR: The squaring cores (--square) are built from their own\n"
+				"\ttableau, signed by Baugh-Wooley, with every stage registered,\n"
+				"\tand so take none of -b, -w, -l, -t, --dsp, --mac, --out-bits,\n"
+				"\t--complex, --simd, --dot, -k, -s, or -n\n");
+			exit(EXIT_FAILURE);
+		} else if (csa_layers < 0) {
+			fprintf(stderr, "ERR: There can\'t be fewer than zero compressor layers per clock\n");
+			exit(EXIT_FAILURE);
+		}
+
+		na = atoi(argv[optind]);
+		if ((na < 2)||(na > 31)) {
+			fprintf(stderr, "ERR: A squaring core takes from 2 to 31 bits\n");
+			exit(EXIT_FAILURE);
+		}
+
+		buildsquare(core_dir, premul, na, use_aux, async_reset);
+		return(0);
 	}
 
 	na = atoi(argv[optind]);
 	nb = atoi(argv[optind+1]);
 
-	buildmpy(core_dir, premul, na, nb, use_aux, async_reset);
+	if ((booth_flag)&&(bw_flag)) {
+		fprintf(stderr, "ERR: The signed core can be built from Booth rows (-b) or\n"
+			"\tBaugh-Wooley rows (-w), but not both\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((tile_size < 0)||(tile_size == 1)) {
+		fprintf(stderr, "ERR: A tile needs at least two bits\n");
+		exit(EXIT_FAILURE);
+	} else if ((karatsuba_flag)&&(tile_size == 0)) {
+		fprintf(stderr, "ERR: Karatsuba recursion needs a tile size (-t)\n");
+		exit(EXIT_FAILURE);
+	} else if ((tile_size > 0)&&((booth_flag)||(bw_flag))) {
+		fprintf(stderr, "ERR: Only a signed core built around umpy (neither -b\n"
+			"\tnor -w) can be tiled\n");
+		exit(EXIT_FAILURE);
+	} else if ((tile_size > 0)&&(latency_budget >= 0)) {
+		fprintf(stderr, "ERR: A tiled core registers every stage, and so can't\n"
+			"\tbe given a latency budget (-l)\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((dsp_na > 0)&&((booth_flag)||(bw_flag))) {
+		fprintf(stderr, "ERR: Only a signed core built around umpy (neither -b\n"
+			"\tnor -w) can use hard multipliers\n");
+		exit(EXIT_FAILURE);
+	} else if ((dsp_na > 0)&&(tile_size > 0)) {
+		fprintf(stderr, "ERR: A core can be tiled (-t), or built around hard\n"
+			"\tmultipliers (--dsp), but not both\n");
+		exit(EXIT_FAILURE);
+	} else if ((dsp_na > 0)&&(latency_budget >= 0)) {
+		fprintf(stderr, "ERR: A core built around hard multipliers registers every\n"
+			"\tstage, and so can't be given a latency budget (-l)\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((mac_width != 0)&&(mac_width < na+nb)) {
+		fprintf(stderr, "ERR: A %dx%d MAC needs an accumulator of at least %d bits\n",
+			na, nb, na+nb);
+		exit(EXIT_FAILURE);
+	} else if ((mac_width > 0)&&((tile_size > 0)||(dsp_na > 0)
+			||(latency_budget >= 0))) {
+		fprintf(stderr, "ERR: The MAC cores (--mac) are built from the tableau, with\n"
+			"\tevery stage registered, and so take none of -t, --dsp, or -l\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((out_bits == 0)&&((round_flag)||(varcomp_flag))) {
+		fprintf(stderr, "ERR: --round and --var-comp only apply to the truncated\n"
+			"\tcores, which need --out-bits\n");
+		exit(EXIT_FAILURE);
+	} else if ((out_bits != 0)&&((out_bits < 2)||(out_bits > na+nb))) {
+		fprintf(stderr, "ERR: A truncated %dx%d core keeps from 2 to %d bits of its product\n",
+			na, nb, na+nb);
+		exit(EXIT_FAILURE);
+	} else if ((out_bits > 0)&&(na+nb > 63)) {
+		fprintf(stderr, "ERR: A truncated core\'s error bounds need a product of\n"
+			"\t63 bits or less\n");
+		exit(EXIT_FAILURE);
+	} else if ((out_bits > 0)&&((tile_size > 0)||(dsp_na > 0)
+			||(latency_budget >= 0))) {
+		fprintf(stderr, "ERR: The truncated cores (--out-bits) are built from the\n"
+			"\ttableau, with every stage registered, and so take none of -t,\n"
+			"\t--dsp, or -l\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((cmplx_flag)&&((tile_size > 0)||(dsp_na > 0)
+			||(latency_budget >= 0))) {
+		fprintf(stderr, "ERR: The complex core (--complex) is built from signed cores\n"
+			"\tone bit wider than the operands, with every stage registered,\n"
+			"\tand so takes none of -t, --dsp, or -l\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Every lane width, from the narrowest up, must be twice the last,
+	// with two lanes at least
+	if ((simd_width != 0)&&(na != nb)) {
+		fprintf(stderr, "ERR: The lanes of a packed SIMD core (--simd) pair up, and so\n"
+			"\tneed operands of the same width\n");
+		exit(EXIT_FAILURE);
+	} else if ((simd_width != 0)&&((simd_width < 2)||(na % simd_width != 0)
+			||(na / simd_width < 2)
+			||((na / simd_width) & (na / simd_width - 1)))) {
+		fprintf(stderr, "ERR: The lanes of a %d-bit SIMD core are %d/2, %d/4, ... bits\n"
+			"\twide, and so its narrowest lane, %d, must be one of those\n",
+			na, na, na, simd_width);
+		exit(EXIT_FAILURE);
+	} else if ((simd_width > 0)&&((tile_size > 0)||(dsp_na > 0)
+			||(latency_budget >= 0))) {
+		fprintf(stderr, "ERR: The packed SIMD core (--simd) is built from the tableau,\n"
+			"\twith every stage registered, and so takes none of -t, --dsp,\n"
+			"\tor -l\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((dot_count < 0)||(dot_count == 1)) {
+		fprintf(stderr, "ERR: A dot product (--dot) needs at least two products\n");
+		exit(EXIT_FAILURE);
+	} else if ((dot_count > 0)&&((tile_size > 0)||(dsp_na > 0)
+			||(latency_budget >= 0))) {
+		fprintf(stderr, "ERR: The dot product cores (--dot) are built from the\n"
+			"\ttableau, with every stage registered, and so take none of -t,\n"
+			"\t--dsp, or -l\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (csa_layers < 0) {
+		fprintf(stderr, "ERR: There can\'t be fewer than zero compressor layers per clock\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// The bit-sliced model only follows the tableau of a plain core
+	if ((bitslice)&&((booth_flag)||(bw_flag)||(csa_layers > 0)
+			||(tiled(na, nb))||(dsp_na > 0))) {
+		fprintf(stderr, "ERR: The bit-sliced model (-s) follows the adder tree of the\n"
+			"\tplain cores, and so takes none of -b, -w, -c, -t, or --dsp\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((lanes < 0)||(lanes == 1)) {
+		fprintf(stderr, "ERR: A lane wrapper needs at least two lanes\n");
+		exit(EXIT_FAILURE);
+	}
+
+	buildmpy(core_dir, premul, na, nb, use_aux, async_reset, bitslice, lanes);
 
 	return(0);
 }